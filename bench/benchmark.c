@@ -0,0 +1,623 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    benchmark.c
+
+    Benchmark of the sorting functions declared in sorting.h. Every
+    function in the table algos[] is run over a range of sizes and
+    over the input distributions discussed in doc/en/ONBestCase.md:
+
+        sorted    0, 1, 2, ... N-1
+        nearly    sorted, then k random pairs swapped (-k option)
+        reversed  N-1, ... 1, 0
+        equal     all elements equal
+        fewuniq   random values among 16 distinct ones
+        sawtooth  ascending runs of length sqrt(N)
+        organpipe 0, 1, 2, ... N/2 ... 2, 1, 0
+        appended  sorted, then k random values at the end (-k)
+        random    uniformly distributed random values
+
+    The output is CSV (default) or JSON, one record per algorithm,
+    distribution and size, with the time per element in
+    nanoseconds. Every result is checked, so a regression in
+    correctness shows up as verified=0 (or false).
+
+    If the program and the library are compiled with SORTING_STATS
+    defined (see sortstats.h), every record also includes the
+    comparisons, reads and writes per element, and the average
+    and maximum depth of the sifts.
+
+    Build it with "make benchmark" (see the Makefile at the top of
+    the repository), or from the src directory with something like:
+
+        cc -O2 -I. -o ../bench/benchmark ../bench/benchmark.c *.c \
+           -lm -lpthread
+
+    Usage:
+
+        benchmark [-min N] [-max N] [-perdecade N] [-k N]
+                  [-mintime SECONDS] [-threads N] [-seed N] [-json]
+                  [-algo NAME]... [-dist NAME]...
+
+    By default the sizes go from 16 to 10^6 with one size per
+    decade (16, 100, 1000, ...). Each measurement is repeated
+    until it adds up to at least 0.2 seconds, sorting a fresh copy
+    of the input every time (the copy is not timed). Small sizes
+    are run in batches of many copies, so that the timer's
+    resolution doesn't matter
+
+    Every algorithm may narrow that range in algos[], so that the
+    default run takes minutes, not hours: the insertion sorts,
+    that are O(N^2), stop at QUADRATIC_MAX, sortnet() at
+    SORTNET_MAX (it calls quicksort() above), the _64 and _payload
+    variants, that repeat the code of other functions, only run
+    at VARIANT_SIZE, and the parallel sorts start at PARALLEL_MIN
+    (below, the pool costs more than the sort). An explicit -min
+    or -max replaces these ranges, for all the algorithms
+    selected (e.g. -max 100000000 for the largest arrays).
+
+    The parallel sorts use one thread per processor, unless a
+    different number is given with -threads
+    ---------------------------------------------------------------
+*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L     // For clock_gettime()
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "sorting.h"
+#include "sortstats.h"
+#include "prefetch.h"
+
+static int threads = 0;         // For the parallel sorts (0: one
+                                // per processor)
+static void run_heapsort_64 (sorteddatatype A[], uint32_t num)
+{
+    heapsort_64 (A, num);
+}
+
+static void run_heapsort_floyd_64 (sorteddatatype A[], uint32_t num)
+{
+    heapsort_floyd_64 (A, num);
+}
+
+static void run_heapsort_branchless_64 (sorteddatatype A[],
+                                        uint32_t num)
+{
+    heapsort_branchless_64 (A, num);
+}
+
+static void run_smoothsort_64 (sorteddatatype A[], uint32_t num)
+{
+    smoothsort_64 (A, num);
+}
+
+static void run_smoothsort_fib_1_64 (sorteddatatype A[], uint32_t num)
+{
+    smoothsort_fib_1_64 (A, num);
+}
+
+static void run_smoothsort_pow2_1_64 (sorteddatatype A[],
+                                      uint32_t num)
+{
+    smoothsort_pow2_1_64 (A, num);
+}
+
+static void run_parallel_sort (sorteddatatype A[], uint32_t num)
+{
+    parallel_sort (A, num, threads);
+}
+
+static void run_parallel_smoothsort (sorteddatatype A[],
+                                     uint32_t num)
+{
+    parallel_sort_kernel (A, num, threads, smoothsort);
+}
+
+static void run_parallel_heapsort (sorteddatatype A[], uint32_t num)
+{
+    parallel_sort_kernel (A, num, threads, heapsort);
+}
+
+static void run_heapsort_parallel (sorteddatatype A[], uint32_t num)
+{
+    heapsort_parallel (A, num, threads);
+}
+
+static payloadtype * payload (uint32_t num) // Row ids 0..num-1
+{                                           // for the *_payload()
+    static payloadtype * P = NULL;          // sorts (refilling them
+    static uint32_t size = 0;               // is timed too, like
+                                            // a copy of the input)
+    uint32_t i;
+
+    if (num > size)
+    {
+        free (P);
+        P = malloc ((size_t)num * sizeof(payloadtype));
+        size = P ? num : 0;
+        if (!P)
+        {
+            fprintf (stderr, "benchmark: not enough memory\n");
+            exit (1);
+        }
+    }
+
+    for (i=0; i<num; i++)
+        P[i] = i;
+
+    return P;
+}
+
+static void run_heapsort_payload (sorteddatatype A[], uint32_t num)
+{
+    heapsort_payload (A, payload (num), num);
+}
+
+static void run_heapsort_floyd_payload (sorteddatatype A[],
+                                        uint32_t num)
+{
+    heapsort_floyd_payload (A, payload (num), num);
+}
+
+static void run_heapsort_branchless_payload (sorteddatatype A[],
+                                             uint32_t num)
+{
+    heapsort_branchless_payload (A, payload (num), num);
+}
+
+static void run_smoothsort_payload (sorteddatatype A[],
+                                    uint32_t num)
+{
+    smoothsort_payload (A, payload (num), num);
+}
+
+#define QUADRATIC_MAX     1000  // Default ranges of sizes of
+#define VARIANT_SIZE   1000000  // some algorithms (see above)
+#define PARALLEL_MIN    100000
+
+static const struct
+{
+    const char * name;
+    sortfunction func;
+    uint32_t     minsize;     // Default range of sizes (others are
+    uint32_t     maxsize;     // skipped, unless -min or -max)
+}
+algos[] =
+{
+    { "smoothsort",          smoothsort, 0, 0 },
+    { "smoothsort_fib_1",    smoothsort_fib_1, 0, 0 },
+    { "smoothsort_pow2_1",   smoothsort_pow2_1, 0, 0 },
+    { "poplarsort",          poplarsort, 0, 0 },
+    { "heapsort",            heapsort, 0, 0 },
+    { "heapsort_floyd",      heapsort_floyd, 0, 0 },
+    { "heapsort_branchless", heapsort_branchless, 0, 0 },
+    { "heapsort_4ary",       heapsort_4ary, 0, 0 },
+    { "heapsort_8ary",       heapsort_8ary, 0, 0 },
+    { "heapsort_weak",       heapsort_weak, 0, 0 },
+    { "quicksort",           quicksort, 0, 0 },
+    { "quicksort_median_of_medians",
+                             quicksort_median_of_medians, 0, 0 },
+    { "combsort",            combsort_cocktail_sqrt2_primes, 0, 0 },
+    { "combsort_simd",       combsort_cocktail_sqrt2_primes_simd, 0, 0 },
+    { "sortnet",             sortnet, 0, SORTNET_MAX },
+    { "radixsort",           radixsort, 0, 0 },
+    { "mergesort_natural",   mergesort_natural, 0, 0 },
+    { "sort_auto",           sort_auto, 0, 0 },
+    { "insertionsort_simple",
+                             insertionsort_simple, 0, QUADRATIC_MAX },
+    { "insertionsort_chained_swaps",
+                             insertionsort_chained_swaps, 0, QUADRATIC_MAX },
+    { "insertionsort_binary_search",
+                             insertionsort_binary_search, 0, QUADRATIC_MAX },
+    { "insertionsort_biased_binary_search",
+                             insertionsort_biased_binary_search,
+                             0, QUADRATIC_MAX },
+    { "smoothsort_64",       run_smoothsort_64, VARIANT_SIZE, VARIANT_SIZE },
+    { "smoothsort_fib_1_64", run_smoothsort_fib_1_64,
+                             VARIANT_SIZE, VARIANT_SIZE },
+    { "smoothsort_pow2_1_64",
+                             run_smoothsort_pow2_1_64,
+                             VARIANT_SIZE, VARIANT_SIZE },
+    { "heapsort_64",         run_heapsort_64, VARIANT_SIZE, VARIANT_SIZE },
+    { "heapsort_floyd_64",   run_heapsort_floyd_64,
+                             VARIANT_SIZE, VARIANT_SIZE },
+    { "heapsort_branchless_64",
+                             run_heapsort_branchless_64,
+                             VARIANT_SIZE, VARIANT_SIZE },
+    { "heapsort_payload",    run_heapsort_payload,
+                             VARIANT_SIZE, VARIANT_SIZE },
+    { "heapsort_floyd_payload",
+                             run_heapsort_floyd_payload,
+                             VARIANT_SIZE, VARIANT_SIZE },
+    { "heapsort_branchless_payload",
+                             run_heapsort_branchless_payload,
+                             VARIANT_SIZE, VARIANT_SIZE },
+    { "smoothsort_payload",  run_smoothsort_payload,
+                             VARIANT_SIZE, VARIANT_SIZE },
+    { "parallel_sort",       run_parallel_sort, PARALLEL_MIN, 0 },
+    { "parallel_smoothsort", run_parallel_smoothsort, PARALLEL_MIN, 0 },
+    { "parallel_heapsort",   run_parallel_heapsort, PARALLEL_MIN, 0 },
+    { "heapsort_parallel",   run_heapsort_parallel, PARALLEL_MIN, 0 }
+};
+
+#define NUM_ALGOS  (sizeof(algos)/sizeof(algos[0]))
+
+static const char * const dists[] =
+{
+    "sorted", "nearly", "reversed", "equal",
+    "fewuniq", "sawtooth", "organpipe", "appended", "random"
+};
+
+#define NUM_DISTS  (sizeof(dists)/sizeof(dists[0]))
+
+#define BATCH_ELEMS  (1UL<<22) // Elements sorted per timed batch
+                               // (for small sizes, many copies)
+static uint64_t rng_state;
+
+static uint64_t rng (void)     // xorshift64*
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+static double now_seconds (void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+
+    QueryPerformanceFrequency (&freq);
+    QueryPerformanceCounter (&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static void generate (sorteddatatype A[], uint32_t num,
+                      int dist, uint32_t k)
+{
+    uint32_t i, j, run;
+    sorteddatatype tmp;
+
+    switch (dist)
+    {
+    case 0:                                         // sorted
+        for (i=0; i<num; i++)
+            A[i] = i;
+        break;
+
+    case 1:                                         // nearly
+        for (i=0; i<num; i++)
+            A[i] = i;
+        for (; k && num>1; k--)
+        {
+            i = (uint32_t)(rng() % num);
+            j = (uint32_t)(rng() % num);
+            tmp = A[i];
+            A[i] = A[j];
+            A[j] = tmp;
+        }
+        break;
+
+    case 2:                                         // reversed
+        for (i=0; i<num; i++)
+            A[i] = num - 1 - i;
+        break;
+
+    case 3:                                         // equal
+        for (i=0; i<num; i++)
+            A[i] = 42;
+        break;
+
+    case 4:                                         // fewuniq
+        for (i=0; i<num; i++)
+            A[i] = (sorteddatatype)(rng() % 16);
+        break;
+
+    case 5:                                         // sawtooth
+        run = (uint32_t) sqrt ((double)num);
+        if (run < 2)
+            run = 2;
+        for (i=0; i<num; i++)
+            A[i] = i % run;
+        break;
+
+    case 6:                                         // organpipe
+        for (i=0; i<num; i++)
+            A[i] = i < num-i ? i : num-i;
+        break;
+
+    case 7:                                         // appended
+        for (i=0; i<num; i++)
+            A[i] = i;
+        for (i = k < num ? num-k : 0; i<num; i++)
+            A[i] = (sorteddatatype)(rng() % num);
+        break;
+
+    default:                                        // random
+        for (i=0; i<num; i++)
+            A[i] = (sorteddatatype)(rng() >> 11);
+        break;
+    }
+}
+
+static int is_sorted (const sorteddatatype A[], uint32_t num)
+{
+    uint32_t i;
+
+    for (i=1; i<num; i++)
+        if (A[i] < A[i-1])
+            return 0;
+
+    return 1;
+}
+
+static int selected (const char * name, char ** list, int count)
+{
+    int i;
+
+    if (count == 0)
+        return 1;
+
+    for (i=0; i<count; i++)
+        if (!strcmp (name, list[i]))
+            return 1;
+
+    return 0;
+}
+
+static int runs (int a, uint32_t num,      // Is algos[a] run with
+                 int userrange,            // num elements?
+                 char ** list, int count)
+{
+    if (!selected (algos[a].name, list, count))
+        return 0;
+
+    if (userrange)               // An explicit range replaces the
+        return 1;                // default one of every algorithm
+
+    return num >= algos[a].minsize &&
+           (!algos[a].maxsize || num <= algos[a].maxsize);
+}
+
+static void usage (void)
+{
+    size_t i;
+
+    fprintf (stderr, "usage: benchmark [-min N] [-max N] "
+                     "[-perdecade N] [-k N] [-mintime SECONDS]\n"
+                     "                 [-threads N] [-seed N] [-json] "
+                     "[-algo NAME]... [-dist NAME]...\n\n"
+                     "algorithms:");
+    for (i=0; i<NUM_ALGOS; i++)
+        fprintf (stderr, " %s", algos[i].name);
+    fprintf (stderr, "\ndistributions:");
+    for (i=0; i<NUM_DISTS; i++)
+        fprintf (stderr, " %s", dists[i]);
+    fprintf (stderr, "\n");
+    exit (EXIT_FAILURE);
+}
+
+int main (int argc, char * argv[])
+{
+    uint32_t minsize = 16;          // Range of sizes
+    uint32_t maxsize = 1000000;
+    int userrange = 0;              // Given with -min or -max
+    int perdecade = 1;              // Sizes per decade (>=1)
+    uint32_t k = 0;                 // Swaps for "nearly" and values
+                                    // for "appended" (0=auto)
+    double mintime = 0.2;           // Min. measured time per case
+    int json = 0;
+
+    char ** algonames, ** distnames;
+    int nalgonames = 0, ndistnames = 0;
+
+    sorteddatatype * input, * work;
+    char * workmem;                 // Allocated block with 'work'
+    uint32_t sizes[64];
+    uint32_t largest;               // Largest size that is run
+    int nsizes = 0;
+    double x;
+    int first = 1;
+    int a, d, s;
+
+    algonames = malloc (argc * sizeof(char *));
+    distnames = malloc (argc * sizeof(char *));
+    rng_state = 88172645463325252ULL;
+
+    for (a=1; a<argc; a++)
+    {
+        if (a+1 < argc && !strcmp (argv[a], "-min"))
+        {
+            minsize = (uint32_t) strtoul (argv[++a], NULL, 10);
+            userrange = 1;
+        }
+        else if (a+1 < argc && !strcmp (argv[a], "-max"))
+        {
+            maxsize = (uint32_t) strtoul (argv[++a], NULL, 10);
+            userrange = 1;
+        }
+        else if (a+1 < argc && !strcmp (argv[a], "-perdecade"))
+            perdecade = atoi (argv[++a]);
+        else if (a+1 < argc && !strcmp (argv[a], "-k"))
+            k = (uint32_t) strtoul (argv[++a], NULL, 10);
+        else if (a+1 < argc && !strcmp (argv[a], "-mintime"))
+            mintime = atof (argv[++a]);
+        else if (a+1 < argc && !strcmp (argv[a], "-threads"))
+            threads = atoi (argv[++a]);
+        else if (a+1 < argc && !strcmp (argv[a], "-seed"))
+            rng_state = strtoull (argv[++a], NULL, 10) | 1;
+        else if (a+1 < argc && !strcmp (argv[a], "-algo"))
+            algonames[nalgonames++] = argv[++a];
+        else if (a+1 < argc && !strcmp (argv[a], "-dist"))
+            distnames[ndistnames++] = argv[++a];
+        else if (!strcmp (argv[a], "-json"))
+            json = 1;
+        else
+            usage ();
+    }
+
+    if (minsize < 1 || maxsize < minsize || perdecade < 1)
+        usage ();
+                                       // Sizes: minsize, and then
+    sizes[nsizes++] = minsize;         // the powers of 10 (or
+                                       // 'perdecade' steps per
+    for (x=100; nsizes<64; x*=pow (10.0, 1.0/perdecade))
+    {                                  // decade) up to maxsize
+        if (x > maxsize + 0.5)
+            break;
+        if ((uint32_t)(x+0.5) > sizes[nsizes-1])
+            sizes[nsizes++] = (uint32_t)(x+0.5);
+    }
+
+    for (s=0, largest=1; s<nsizes; s++)     // Memory for the largest
+        for (a=0; a<(int)NUM_ALGOS; a++)    // size that is run
+            if (runs (a, sizes[s], userrange, algonames, nalgonames) &&
+                sizes[s] > largest)
+                largest = sizes[s];
+
+    input = malloc ((size_t)largest * sizeof(sorteddatatype));
+    workmem = malloc (((size_t)largest > BATCH_ELEMS ? largest
+                                                     : BATCH_ELEMS)
+                      * sizeof(sorteddatatype) + CACHE_LINE);
+                                         // Align the sorted copies
+    work = (sorteddatatype *)            // to a cache line, so that
+           (workmem + CACHE_LINE         // the d-ary heaps keep the
+            - (uintptr_t)workmem % CACHE_LINE);    // siblings in one
+                                                   // line
+    if (!input || !workmem)
+    {
+        fprintf (stderr, "benchmark: not enough memory\n");
+        return EXIT_FAILURE;
+    }
+
+    if (json)
+        printf ("[\n");
+    else
+        printf ("algorithm,distribution,size,repetitions,"
+                "ns_per_element,total_seconds,verified"
+#ifdef SORTING_STATS
+                ",cmp_per_element,reads_per_element,"
+                "writes_per_element,avg_sift_depth,max_sift_depth"
+#endif
+                "\n");
+
+    for (s=0; s<nsizes; s++)
+    for (d=0; d<(int)NUM_DISTS; d++)
+    {
+        uint32_t num = sizes[s];
+        uint32_t copies;             // Copies sorted per batch
+
+        if (!selected (dists[d], distnames, ndistnames))
+            continue;
+
+        for (a=0; a<(int)NUM_ALGOS; a++)     // Skip the sizes that
+            if (runs (a, num, userrange,     // no algorithm runs
+                      algonames, nalgonames))
+                break;
+
+        if (a == (int)NUM_ALGOS)
+            continue;
+                                                  // Default k:
+        generate (input, num, d, k ? k : num/100+1); // 1% of num
+
+        copies = num < BATCH_ELEMS ? BATCH_ELEMS / num : 1;
+
+        for (a=0; a<(int)NUM_ALGOS; a++)
+        {
+            double elapsed = 0, t0;
+            unsigned long reps = 0;
+            int verified = 1;
+            uint32_t c;
+
+            if (!runs (a, num, userrange, algonames, nalgonames))
+                continue;
+
+            sortstats_reset ();
+
+            while (elapsed < mintime)
+            {
+                for (c=0; c<copies; c++)
+                    memcpy (work + (size_t)c*num, input,
+                            num * sizeof(sorteddatatype));
+
+                t0 = now_seconds ();
+                for (c=0; c<copies; c++)
+                    algos[a].func (work + (size_t)c*num, num);
+                elapsed += now_seconds () - t0;
+
+                reps += copies;
+                verified &= is_sorted (work, num);
+            }
+
+            if (json)
+                printf ("%s  { \"algorithm\": \"%s\", "
+                        "\"distribution\": \"%s\", \"size\": %lu, "
+                        "\"repetitions\": %lu, "
+                        "\"ns_per_element\": %.4f, "
+                        "\"total_seconds\": %.6f, "
+                        "\"verified\": %s",
+                        first ? "" : ",\n",
+                        algos[a].name, dists[d], (unsigned long)num,
+                        reps, elapsed * 1e9 / ((double)reps * num),
+                        elapsed, verified ? "true" : "false");
+            else
+                printf ("%s,%s,%lu,%lu,%.4f,%.6f,%d",
+                        algos[a].name, dists[d], (unsigned long)num,
+                        reps, elapsed * 1e9 / ((double)reps * num),
+                        elapsed, verified);
+
+#ifdef SORTING_STATS
+            {
+                sortstats * st = sortstats_get ();
+                double elems = (double)reps * num;
+
+                printf (json ? ", \"cmp_per_element\": %.4f, "
+                               "\"reads_per_element\": %.4f, "
+                               "\"writes_per_element\": %.4f, "
+                               "\"avg_sift_depth\": %.4f, "
+                               "\"max_sift_depth\": %lu"
+                             : ",%.4f,%.4f,%.4f,%.4f,%lu",
+                        st->comparisons / elems,
+                        st->reads / elems,
+                        st->writes / elems,
+                        st->sifts ? (double)st->sift_levels / st->sifts
+                                  : 0.0,
+                        (unsigned long)st->sift_depth_max);
+            }
+#endif
+            printf (json ? " }" : "\n");
+
+            first = 0;
+            fflush (stdout);
+        }
+    }
+
+    if (json)
+        printf ("\n]\n");
+
+    free (input);
+    free (workmem);
+    free (algonames);
+    free (distnames);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    bitops.h
+
+    Bit scans used by the sorting functions. With GCC, Clang and
+    MSVC they compile to a single instruction (BSF/TZCNT on x86,
+    RBIT+CLZ on ARM). With other compilers, a plain loop is used.
+    The argument must not be 0
+    -------------------------------------------------------------
+*/
+
+#ifndef _BITOPS_MKR_H_
+#define _BITOPS_MKR_H_
+
+#include <stdint.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+static inline int ctz32 (uint32_t x)   // Num. of trailing zeros
+{
+#if defined(__GNUC__)
+    return __builtin_ctz (x);
+#elif defined(_MSC_VER)
+    unsigned long i;
+
+    _BitScanForward (&i, x);
+    return (int) i;
+#else
+    int n;
+
+    for (n=0; !(x&1); n++)
+        x >>= 1;
+
+    return n;
+#endif
+}
+
+static inline int ctz64 (uint64_t x)   // Num. of trailing zeros
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll (x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long i;
+
+    _BitScanForward64 (&i, x);
+    return (int) i;
+#else
+    return (uint32_t) x ? ctz32 ((uint32_t) x)
+                        : 32 + ctz32 ((uint32_t) (x >> 32));
+#endif
+}
+
+#endif // _BITOPS_MKR_H_
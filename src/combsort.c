@@ -0,0 +1,217 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    combsort.c
+
+    Implementation of combsort (Wlodzimierz Dobosiewicz, 1980;
+    Stephen Lacey and Richard Box, 1991) with three changes:
+
+       1) COCKTAIL: The passes go alternately from left to right
+          and from right to left, so that small values near the
+          end ("turtles") travel as fast as great values near the
+          beginning ("rabbits")
+
+       2) SQRT2: The gap is divided by sqrt(2) after every pass,
+          instead of the usual 1.3
+
+       3) PRIMES: Every gap is rounded down to a prime number, so
+          that consecutive gaps have no common factors and the
+          passes mix different elements
+
+    When the gap reaches 1, a cocktail shaker sort finishes the
+    work. It stops when a pass makes no swaps, and every pass
+    skips the part that the previous one left sorted. After the
+    comb passes there are very few inversions left, so it takes
+    only a couple of passes. The total is O(1) extra memory and,
+    in practice, O(N log N) time (there are inputs that make it
+    quadratic, but they are hard to find).
+
+    Every comparator of a comb pass is branchless (a min. and a
+    max.). There are two versions:
+
+       1) combsort_cocktail_sqrt2_primes() does them one by one
+
+       2) combsort_cocktail_sqrt2_primes_simd() does W of them at
+          once with SIMD vectors whenever the gap is W or more
+          (see combsort_kernel.h). There are versions for SSE2
+          (W=2), AVX2 (4) and AVX-512 (8), and the best one
+          supported by the processor is chosen at run time, like
+          in sortnet.c. It gives the same result as the first one
+
+    The scalar version is some 2-3 times slower than quicksort()
+    with random data. The SIMD version, with AVX-512, is 2.5-4
+    times faster than the scalar one, and as fast as quicksort()
+    from about 10^4 elements. The vector versions assume that
+    sorteddatatype is double. Both can be instrumented (see
+    sortstats.h)
+    ---------------------------------------------------------------
+*/
+
+#include "sorting.h"
+#include "sortstats.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COMBSORT_X86
+#include <immintrin.h>
+#endif
+
+typedef void (*combfunc) (sorteddatatype A[], uint32_t len);
+
+static inline uint32_t next_gap (uint32_t gap);
+
+static void shaker (sorteddatatype A[], uint32_t len);
+
+// Scalar version
+
+#define NAME(x)     x##_scalar
+#define TARGET
+#define W           1
+#define vec         sorteddatatype
+#define LOAD(p)     (*(p))
+#define STORE(p,v)  (*(p) = (v))
+#define MIN(a,b)    ((b) < (a) ? (b) : (a))
+#define MAX(a,b)    ((b) > (a) ? (b) : (a))
+#include "combsort_kernel.h"
+
+#ifdef COMBSORT_X86
+
+// SSE2 version (2 doubles per vector)
+
+#define NAME(x)     x##_sse2
+#define TARGET      __attribute__ ((target ("sse2")))
+#define W           2
+#define vec         __m128d
+#define LOAD(p)     _mm_loadu_pd (p)
+#define STORE(p,v)  _mm_storeu_pd ((p), (v))
+#define MIN(a,b)    _mm_min_pd ((a), (b))
+#define MAX(a,b)    _mm_max_pd ((a), (b))
+#include "combsort_kernel.h"
+
+// AVX2 version (4 doubles per vector)
+
+#define NAME(x)     x##_avx2
+#define TARGET      __attribute__ ((target ("avx2")))
+#define W           4
+#define vec         __m256d
+#define LOAD(p)     _mm256_loadu_pd (p)
+#define STORE(p,v)  _mm256_storeu_pd ((p), (v))
+#define MIN(a,b)    _mm256_min_pd ((a), (b))
+#define MAX(a,b)    _mm256_max_pd ((a), (b))
+#include "combsort_kernel.h"
+
+// AVX-512 version (8 doubles per vector)
+
+#define NAME(x)     x##_avx512
+#define TARGET      __attribute__ ((target ("avx512f")))
+#define W           8
+#define vec         __m512d
+#define LOAD(p)     _mm512_loadu_pd (p)
+#define STORE(p,v)  _mm512_storeu_pd ((p), (v))
+#define MIN(a,b)    _mm512_min_pd ((a), (b))
+#define MAX(a,b)    _mm512_max_pd ((a), (b))
+#include "combsort_kernel.h"
+
+#endif // COMBSORT_X86
+
+static inline combfunc comb_simd (void)
+{                                   // Choose the best version for
+#ifdef COMBSORT_X86                 // this processor
+    if (__builtin_cpu_supports ("avx512f"))
+        return comb_avx512;
+    if (__builtin_cpu_supports ("avx2"))
+        return comb_avx2;
+    if (__builtin_cpu_supports ("sse2"))
+        return comb_sse2;
+#endif
+    return comb_scalar;
+}
+
+void combsort_cocktail_sqrt2_primes (
+                    sorteddatatype A[],    // Array to be sorted
+                    uint32_t len)          // Size of the array
+{
+    if (len < 2)
+        return;
+
+    comb_scalar (A, len);
+    shaker (A, len);
+}
+
+void combsort_cocktail_sqrt2_primes_simd (
+                    sorteddatatype A[],    // Array to be sorted
+                    uint32_t len)          // Size of the array
+{
+    if (len < 2)
+        return;
+
+    comb_simd () (A, len);
+    shaker (A, len);
+}
+
+static inline uint32_t next_gap (uint32_t gap)
+{
+    uint32_t d;
+                                       // Divide by sqrt(2) and
+    gap = (uint32_t) (gap * 0.70710678118654752);  // go down to
+                                       // the nearest prime
+    for (; gap>3; gap--)
+    {
+        if (!(gap & 1))
+            continue;
+
+        for (d=3; d*d<=gap && gap%d; d+=2)
+            ;
+
+        if (d*d > gap)
+            break;
+    }
+
+    return gap;
+}
+
+static void shaker (sorteddatatype A[], uint32_t len)
+{
+    sorteddatatype tmp;
+    uint32_t lo, hi;     // Unsorted part: [lo,hi]
+    uint32_t i, last;    // Last swap of a pass
+
+    lo = 0;
+    hi = len - 1;
+
+    while (lo < hi)
+    {
+        for (i=last=lo; i<hi; i++)   // Left to right
+        {
+            STAT_READ (2);
+            STAT_CMP (1);
+
+            if (A[i+1] < A[i])
+            {
+                tmp = A[i];
+                A[i] = A[i+1];
+                A[i+1] = tmp;
+                last = i;
+                STAT_WRITE (2);
+            }
+        }
+        hi = last;           // A[last+1...] are in place
+
+        for (i=last=hi; i>lo; i--)   // Right to left
+        {
+            STAT_READ (2);
+            STAT_CMP (1);
+
+            if (A[i] < A[i-1])
+            {
+                tmp = A[i];
+                A[i] = A[i-1];
+                A[i-1] = tmp;
+                last = i;
+                STAT_WRITE (2);
+            }
+        }
+        lo = last;           // A[...last-1] are in place
+    }
+}
@@ -0,0 +1,130 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    combsort_kernel.h
+
+    Passes of combsort for vectors of W elements. This is not a
+    regular header: combsort.c includes it once per instruction
+    set, with the same macros as sortnet_kernel.h:
+
+        NAME(x)      Name of the function x for this set
+        TARGET       Attribute that enables the set (or nothing)
+        W            Elements per vector
+        vec          Vector type
+        LOAD(p)      Load W elements from address p
+        STORE(p,v)   Store the W elements of v at address p
+        MIN(a,b)     Lane by lane, a<b ? a : b
+        MAX(a,b)     Lane by lane, a>b ? a : b
+
+    A pass compares every A[i] with A[i+gap], from the first i
+    to the last one (up) or the other way round (down), putting
+    the min. first. When gap>=W, the W comparators that start at
+    A[i]...A[i+W-1] don't touch each other's elements, so they
+    are done with one MIN and one MAX of vectors. The order of
+    the passes is kept: a vector never reads an element before
+    the comparator that precedes it in the pass has written it.
+    So the result is exactly that of the scalar pass. The few
+    comparators that don't fill a vector are done one by one
+    -------------------------------------------------------------
+*/
+
+TARGET static void NAME(pass_up) (
+        sorteddatatype A[],     // Array of len elements
+        uint32_t       len,
+        uint32_t       gap)     // Distance of the comparators
+{
+    uint32_t i;
+    vec a, c;
+    sorteddatatype x, y;
+
+    i = 0;
+
+    if (gap >= W)
+        for (; i+W<=len-gap; i+=W)
+        {
+            a = LOAD (A+i);
+            c = LOAD (A+i+gap);
+            STORE (A+i,     MIN (a, c));
+            STORE (A+i+gap, MAX (c, a));
+            STAT_READ (2*W);
+            STAT_CMP (W);
+            STAT_WRITE (2*W);
+        }
+
+    for (; i<len-gap; i++)
+    {
+        x = A[i];
+        y = A[i+gap];
+        A[i]     = y < x ? y : x;
+        A[i+gap] = y < x ? x : y;
+        STAT_READ (2);
+        STAT_CMP (1);
+        STAT_WRITE (2);
+    }
+}
+
+TARGET static void NAME(pass_down) (
+        sorteddatatype A[],     // Array of len elements
+        uint32_t       len,
+        uint32_t       gap)     // Distance of the comparators
+{
+    uint32_t i;
+    vec a, c;
+    sorteddatatype x, y;
+
+    i = len - gap;              // Comparators not done yet: [0,i)
+
+    if (gap >= W)
+        for (; i>=W; i-=W)
+        {
+            a = LOAD (A+i-W);
+            c = LOAD (A+i-W+gap);
+            STORE (A+i-W,     MIN (a, c));
+            STORE (A+i-W+gap, MAX (c, a));
+            STAT_READ (2*W);
+            STAT_CMP (W);
+            STAT_WRITE (2*W);
+        }
+
+    while (i--)
+    {
+        x = A[i];
+        y = A[i+gap];
+        A[i]     = y < x ? y : x;
+        A[i+gap] = y < x ? x : y;
+        STAT_READ (2);
+        STAT_CMP (1);
+        STAT_WRITE (2);
+    }
+}
+
+TARGET static void NAME(comb) (
+        sorteddatatype A[],     // Array to be sorted
+        uint32_t       len)     // Size of the array (>=2)
+{
+    uint32_t gap;
+    int up;
+
+    up = 1;
+
+    for (gap=next_gap (len); gap>1; gap=next_gap (gap))
+    {
+        if (up)
+            NAME(pass_up) (A, len, gap);
+        else
+            NAME(pass_down) (A, len, gap);
+
+        up = !up;
+    }
+}
+
+#undef NAME
+#undef TARGET
+#undef W
+#undef vec
+#undef LOAD
+#undef STORE
+#undef MIN
+#undef MAX
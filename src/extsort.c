@@ -0,0 +1,748 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    extsort.c
+
+    External sort for binary files of doubles that don't fit in
+    memory. It works in two phases:
+
+       1) RUNS: The input is read in chunks of half the memory
+          budget. Every chunk is sorted with an in-memory kernel
+          (quicksort() by default) and written to a temporary
+          file (a "run"). While a chunk is being sorted, the next
+          one is read into the other half of the memory, and the
+          previous one is still being written
+
+       2) MERGE: The runs are merged with a k-way merge. The
+          smallest head of the runs is taken from a binary heap
+          of (value, run) pairs. Every run has two input buffers:
+          one is consumed by the merge while the other one is
+          filled. The output has two buffers too. If there are so
+          many runs that the buffers would be smaller than
+          MIN_BUFFER bytes, groups of runs are merged into longer
+          runs first
+
+    All the reads and writes are done in large blocks by a
+    background I/O thread. It serves the requests in the order
+    they are submitted, so a buffer can be reused for a read as
+    soon as its write has been submitted. If the input fits in
+    one chunk, it is sorted in memory and written directly.
+
+    The runs are written to a new directory, created with
+    mkdtemp() in the temporary directory, so concurrent sorts
+    never share a file and no existing file is overwritten. The
+    sorted data goes to a new file next to the output (created
+    with O_EXCL), that replaces it with rename() only if the sort
+    succeeds. So, the output can be the input, and a failure
+    leaves both as they were (a symbolic link as the output is
+    replaced by the sorted file, though). All the temporary files
+    are removed at the end, even on failure. The time and bytes
+    transferred in every phase are returned in an extsort_stats
+    struct, and optionally reported on stderr
+    ---------------------------------------------------------------
+*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L     // For clock_gettime(), mkdtemp()
+#define _FILE_OFFSET_BITS 64        // For files of more than 2 GB
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "sorting.h"
+
+#ifndef EXTSORT_DEFAULT_MEMORY                 // Memory budget if
+#define EXTSORT_DEFAULT_MEMORY  ((size_t)1<<30)  // none is given
+#endif                                         // (bytes)
+
+#define MIN_BUFFER  ((size_t)1<<20)  // Min. merge buffer (bytes)
+#define MAX_CHUNK   0xFFFFFFFFUL     // Max. elements of a run (the
+                                     // kernels take uint32_t sizes)
+#define NAME_MAX_LEN  4096
+
+// ASYNCHRONOUS I/O
+
+typedef struct iorequest
+{
+    FILE * f;
+    sorteddatatype * data;
+    size_t num;           // Elements to read/write
+    size_t done;          // Elements actually read/written
+    int write;            // Write (1) or read (0)
+    int error;            // The stream failed
+    int pending;          // Submitted and not finished yet
+    struct iorequest * next;
+}
+iorequest;
+
+typedef struct
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;  // Signaled when a request is queued
+    pthread_cond_t done;  // Signaled when a request is finished
+    iorequest * head;     // Queue of requests (FIFO)
+    iorequest * tail;
+    int stop;
+}
+ioworker;
+
+static void * io_thread (void * arg)
+{
+    ioworker * w = arg;
+    iorequest * r;
+    size_t done;
+    int error;
+
+    for (;;)
+    {
+        pthread_mutex_lock (&w->lock);
+        while (!w->head && !w->stop)
+            pthread_cond_wait (&w->work, &w->lock);
+
+        r = w->head;
+        if (r)
+        {
+            w->head = r->next;
+            if (!w->head)
+                w->tail = NULL;
+        }
+        pthread_mutex_unlock (&w->lock);
+
+        if (!r)
+            return NULL;
+
+        if (r->write)                        // (Count bytes, to
+            done = fwrite (r->data, 1,       // detect a file that
+                           r->num * sizeof(sorteddatatype), r->f);
+        else                                 // ends with a partial
+            done = fread (r->data, 1,        // element)
+                          r->num * sizeof(sorteddatatype), r->f);
+
+        error = (done < r->num * sizeof(sorteddatatype) &&
+                 ferror (r->f)) ||
+                done % sizeof(sorteddatatype) != 0;
+        done /= sizeof(sorteddatatype);
+
+        pthread_mutex_lock (&w->lock);
+        r->done = done;
+        r->error = error;
+        r->pending = 0;
+        pthread_cond_broadcast (&w->done);
+        pthread_mutex_unlock (&w->lock);
+    }
+}
+
+static int io_start (ioworker * w)
+{
+    w->head = w->tail = NULL;
+    w->stop = 0;
+    pthread_mutex_init (&w->lock, NULL);
+    pthread_cond_init (&w->work, NULL);
+    pthread_cond_init (&w->done, NULL);
+
+    if (pthread_create (&w->thread, NULL, io_thread, w) == 0)
+        return 1;
+
+    pthread_cond_destroy (&w->done);
+    pthread_cond_destroy (&w->work);
+    pthread_mutex_destroy (&w->lock);
+    return 0;
+}
+
+static void io_stop (ioworker * w)     // (Finishes the requests
+{                                      // already submitted)
+    pthread_mutex_lock (&w->lock);
+    w->stop = 1;
+    pthread_cond_signal (&w->work);
+    pthread_mutex_unlock (&w->lock);
+
+    pthread_join (w->thread, NULL);
+    pthread_cond_destroy (&w->done);
+    pthread_cond_destroy (&w->work);
+    pthread_mutex_destroy (&w->lock);
+}
+
+static void io_submit (ioworker * w, iorequest * r, FILE * f,
+                       sorteddatatype * data, size_t num, int write)
+{
+    r->f = f;
+    r->data = data;
+    r->num = num;
+    r->done = 0;
+    r->write = write;
+    r->error = 0;
+    r->pending = 1;
+    r->next = NULL;
+
+    pthread_mutex_lock (&w->lock);
+    if (w->tail)
+        w->tail->next = r;
+    else
+        w->head = r;
+    w->tail = r;
+    pthread_cond_signal (&w->work);
+    pthread_mutex_unlock (&w->lock);
+}
+
+static size_t io_wait (ioworker * w, iorequest * r, int * error)
+{                                      // Returns the elements read
+    pthread_mutex_lock (&w->lock);     // or written. Sets *error
+    while (r->pending)                 // if the stream failed. (It
+        pthread_cond_wait (&w->done, &w->lock);   // always takes the
+                                       // lock, so that the caller
+                                       // sees the data written by
+                                       // the I/O thread. A zeroed
+                                       // request is a finished one)
+    pthread_mutex_unlock (&w->lock);
+
+    if (r->error || (r->write && r->done < r->num))
+        *error = 1;
+
+    return r->done;
+}
+
+// STATE OF A SORT
+
+typedef struct
+{
+    char dir[NAME_MAX_LEN-16];  // Own directory of the runs
+                                // (with room for their names)
+    char tmpout[NAME_MAX_LEN];  // Output until it's renamed
+    uint32_t nextrun;     // Sequence number of the next run
+    size_t memory;        // Memory budget (bytes)
+    sortfunction kernel;
+    ioworker io;
+    int error;            // Some operation failed
+    int err;              // Its errno (0 if unknown)
+
+    uint32_t * runs;      // Queue of runs to merge (their
+    uint32_t first;       // sequence numbers)
+    uint32_t count;
+    uint32_t cap;
+}
+extsorter;
+
+static inline double seconds (void)
+{
+#ifdef _WIN32
+    return (double) clock () / CLOCKS_PER_SEC;
+#else
+    struct timespec t;
+
+    clock_gettime (CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+static inline void fail (extsorter * s)
+{
+    if (!s->error)        // Keep the errno of the first failure
+    {
+        s->error = 1;
+        s->err = errno;
+    }
+}
+
+static void run_name (const extsorter * s, uint32_t run, char * name)
+{
+    snprintf (name, NAME_MAX_LEN, "%s/%lu.run",
+              s->dir, (unsigned long) run);
+}
+
+static FILE * open_file (extsorter * s, const char * name,
+                         const char * mode)
+{
+    FILE * f;
+
+    f = fopen (name, mode);
+    if (!f)
+        fail (s);
+    else                               // All reads and writes are
+        setvbuf (f, NULL, _IONBF, 0);  // large, so skip the copy
+                                       // to the stdio buffer
+    return f;
+}
+
+static void close_file (extsorter * s, FILE * f)
+{
+    if (f && fclose (f) != 0)
+        fail (s);
+}
+
+static FILE * open_output (extsorter * s, const char * output)
+{
+    FILE * f;             // Create a new file next to the output
+    const char * tag;     // (named after the directory of the
+    int fd;               // runs, that is unique), and fail
+                          // rather than overwrite one
+    tag = strrchr (s->dir, '/');
+    tag = tag ? tag+1 : s->dir;
+
+    if (snprintf (s->tmpout, NAME_MAX_LEN, "%s.%s", output, tag)
+        >= NAME_MAX_LEN)
+    {
+        s->tmpout[0] = 0;
+        errno = ENAMETOOLONG;
+        fail (s);
+        return NULL;
+    }
+
+    fd = open (s->tmpout, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (fd < 0)
+    {
+        s->tmpout[0] = 0;
+        fail (s);
+        return NULL;
+    }
+
+    f = fdopen (fd, "wb");
+    if (!f)
+    {
+        fail (s);
+        close (fd);
+        return NULL;
+    }
+
+    setvbuf (f, NULL, _IONBF, 0);
+    return f;
+}
+
+static FILE * new_run (extsorter * s)  // Create the next run file
+{                                      // and add it to the queue
+    char name[NAME_MAX_LEN];
+    uint32_t * runs;
+    uint32_t i;
+
+    if (s->count == s->cap)            // Grow the queue (and move
+    {                                  // it to the beginning)
+        runs = malloc ((size_t)(2*s->cap + 16) * sizeof(uint32_t));
+        if (!runs)
+        {
+            fail (s);
+            return NULL;
+        }
+        for (i=0; i<s->count; i++)
+            runs[i] = s->runs[s->first + i];
+        free (s->runs);
+        s->runs = runs;
+        s->first = 0;
+        s->cap = 2*s->cap + 16;
+    }
+    else if (s->first + s->count == s->cap)
+    {
+        memmove (s->runs, s->runs + s->first,
+                 s->count * sizeof(uint32_t));
+        s->first = 0;
+    }
+
+    run_name (s, s->nextrun, name);
+    s->runs[s->first + s->count++] = s->nextrun++;
+
+    return open_file (s, name, "wb");
+}
+
+// 1st PHASE: GENERATE THE RUNS
+
+static uint64_t make_runs (extsorter * s, FILE * in,
+                           const char * output, uint64_t * bytes)
+{                                      // (Closes 'in')
+    sorteddatatype * buf[2];   // Chunk being sorted and next chunk
+    iorequest rd, wr;
+    FILE * f, * prev;
+    uint64_t total;
+    size_t chunk, n, m;
+    int cur;
+
+    chunk = s->memory / 2 / sizeof(sorteddatatype);
+    if (chunk > MAX_CHUNK)
+        chunk = MAX_CHUNK;
+    if (chunk < 1)
+        chunk = 1;
+
+    buf[0] = malloc (chunk * sizeof(sorteddatatype));
+    buf[1] = malloc (chunk * sizeof(sorteddatatype));
+    total = 0;
+    prev = NULL;
+
+    memset (&wr, 0, sizeof(wr));
+    n = 0;
+
+    if (!buf[0] || !buf[1])
+        fail (s);
+    else
+    {
+        io_submit (&s->io, &rd, in, buf[0], chunk, 0);
+        n = io_wait (&s->io, &rd, &s->error);
+    }
+
+    for (cur=0; n>0 && !s->error; cur^=1)
+    {                                    // Read the next chunk
+        io_submit (&s->io, &rd, in, buf[cur^1], chunk, 0);  // while
+        s->kernel (buf[cur], (uint32_t) n);                 // this
+        m = io_wait (&s->io, &rd, &s->error);       // one is sorted
+        total += n;
+
+        if (s->error)
+            break;
+                                         // The previous write was
+        io_wait (&s->io, &wr, &s->error);  // submitted before that
+        close_file (s, prev);              // read, so it is done
+                                           // by now
+        prev = NULL;
+                                         // If it is the only chunk,
+        if (s->nextrun == 0 && m == 0)   // write it to the output
+        {                                // (that may be the input)
+            fclose (in);
+            in = NULL;
+            f = open_output (s, output);
+        }
+        else
+            f = new_run (s);
+
+        if (!f)
+            break;
+
+        io_submit (&s->io, &wr, f, buf[cur], n, 1);
+        prev = f;
+        n = m;
+    }
+
+    io_wait (&s->io, &wr, &s->error);
+    close_file (s, prev);
+
+    if (in)
+        fclose (in);
+                                         // Empty input: create an
+    if (total == 0 && !s->error)         // empty output
+        close_file (s, open_output (s, output));
+
+    if (s->error && !s->err)
+        s->err = EIO;
+
+    free (buf[0]);
+    free (buf[1]);
+
+    *bytes = 2 * total * sizeof(sorteddatatype);
+    return total;
+}
+
+// 2nd PHASE: MERGE THE RUNS
+
+typedef struct
+{
+    FILE * f;
+    sorteddatatype * buf[2];   // Buffer being consumed and buffer
+    int cur;                   // being filled
+    size_t pos, len;           // Position and size of buf[cur]
+    iorequest rq;              // Read of buf[cur^1]
+}
+mergeinput;
+
+typedef struct
+{
+    sorteddatatype key;   // Head of the run
+    uint32_t src;         // Number of the run
+}
+headitem;
+
+static int refill (extsorter * s, mergeinput * in, size_t bufsize)
+{
+    in->len = io_wait (&s->io, &in->rq, &s->error);
+    in->cur ^= 1;                        // Take the buffer just
+    in->pos = 0;                         // read and start reading
+                                         // the next block in the
+    if (in->len > 0)                     // other one
+        io_submit (&s->io, &in->rq, in->f, in->buf[in->cur^1],
+                   bufsize, 0);
+
+    return in->len > 0;
+}
+
+static inline void sift_down (headitem * H, uint32_t num, uint32_t p)
+{
+    headitem tmp;         // Min. heap of the heads of the runs
+    uint32_t c;           // (children of H[p]: H[2p+1], H[2p+2])
+
+    tmp = H[p];
+
+    for (c=2*p+1; c<num; c=2*p+1)
+    {
+        if (c+1 < num && H[c+1].key < H[c].key)
+            c ++;
+
+        if (tmp.key <= H[c].key)
+            break;
+
+        H[p] = H[c];
+        p = c;
+    }
+
+    H[p] = tmp;
+}
+
+static uint64_t merge_runs (extsorter * s, uint32_t k, FILE * out)
+{                             // Merge the first k runs of the
+    mergeinput * in;          // queue into 'out' and remove them
+    headitem * H;
+    sorteddatatype * obuf[2];
+    iorequest wr;
+    char name[NAME_MAX_LEN];
+    uint64_t total;
+    size_t bufsize, o;
+    uint32_t h, i;
+    int oc;
+
+    bufsize = s->memory / (2*(size_t)k + 2) / sizeof(sorteddatatype);
+
+    in = calloc (k, sizeof(mergeinput));
+    H = malloc (k * sizeof(headitem));
+    obuf[0] = malloc (bufsize * sizeof(sorteddatatype));
+    obuf[1] = malloc (bufsize * sizeof(sorteddatatype));
+    total = 0;
+    h = 0;
+
+    if (!in || !H || !obuf[0] || !obuf[1])
+        fail (s);
+
+    for (i=0; i<k && !s->error; i++)     // Open the runs and fill
+    {                                    // the heap with their
+        run_name (s, s->runs[s->first + i], name);         // heads
+        in[i].f = open_file (s, name, "rb");
+        in[i].buf[0] = malloc (bufsize * sizeof(sorteddatatype));
+        in[i].buf[1] = malloc (bufsize * sizeof(sorteddatatype));
+
+        if (!in[i].f || !in[i].buf[0] || !in[i].buf[1])
+        {
+            fail (s);
+            break;
+        }
+
+        in[i].cur = 1;
+        io_submit (&s->io, &in[i].rq, in[i].f, in[i].buf[0],
+                   bufsize, 0);
+        if (refill (s, in + i, bufsize))
+        {
+            H[h].key = in[i].buf[0][0];
+            H[h].src = i;
+            h ++;
+        }
+    }
+
+    for (i=h>>1; i--; )
+        sift_down (H, h, i);
+
+    memset (&wr, 0, sizeof(wr));
+    oc = 0;
+    o = 0;
+
+    while (h > 0 && !s->error)
+    {
+        mergeinput * r = in + H[0].src;
+
+        obuf[oc][o++] = H[0].key;        // Output the smallest head
+
+        if (o == bufsize)                // If the output buffer is
+        {                                // full, write it while the
+            io_wait (&s->io, &wr, &s->error);    // other one
+                                                 // is filled
+            io_submit (&s->io, &wr, out, obuf[oc], o, 1);
+            total += o;
+            oc ^= 1;
+            o = 0;
+        }
+                                         // Replace it with the next
+        if (++r->pos < r->len || refill (s, r, bufsize))  // element
+            H[0].key = r->buf[r->cur][r->pos];     // of its run, or
+        else                                       // remove the run
+            H[0] = H[--h];                         // if it's over
+
+        sift_down (H, h, 0);
+    }
+
+    io_wait (&s->io, &wr, &s->error);
+    if (o > 0 && !s->error)
+    {
+        io_submit (&s->io, &wr, out, obuf[oc], o, 1);
+        io_wait (&s->io, &wr, &s->error);
+        total += o;
+    }
+
+    for (i=0; i<k; i++)                  // Wait for the reads in
+    {                                    // progress, and close and
+        if (in)                          // remove the runs
+        {
+            io_wait (&s->io, &in[i].rq, &s->error);
+            close_file (s, in[i].f);
+            free (in[i].buf[0]);
+            free (in[i].buf[1]);
+        }
+        run_name (s, s->runs[s->first + i], name);
+        remove (name);
+    }
+    s->first += k;
+    s->count -= k;
+
+    if (s->error && !s->err)
+        s->err = EIO;
+
+    free (in);
+    free (H);
+    free (obuf[0]);
+    free (obuf[1]);
+
+    return total;
+}
+
+static void merge_phase (extsorter * s, const char * output,
+                         extsort_stats * st)
+{
+    FILE * out;
+    uint32_t fanin;       // Max. runs merged at once
+
+    fanin = (uint32_t) (s->memory / MIN_BUFFER / 2);
+    if (fanin > 2)
+        fanin --;         // (Two buffers are for the output)
+    if (fanin < 2)
+        fanin = 2;
+
+    while (s->count > fanin && !s->error)    // Merge groups of
+    {                                        // runs into longer
+        out = new_run (s);                   // runs at the end
+        if (!out)                            // of the queue
+            break;
+        st->merge_bytes += 2 * sizeof(sorteddatatype) *
+                           merge_runs (s, fanin, out);
+        close_file (s, out);
+        st->merges ++;
+    }
+
+    if (s->count == 0 || s->error)
+        return;
+
+    out = open_output (s, output);
+    if (!out)
+        return;
+
+    st->merge_bytes += 2 * sizeof(sorteddatatype) *
+                       merge_runs (s, s->count, out);
+    close_file (s, out);
+    st->merges ++;
+}
+
+int extsort (const char * input,         // File to sort
+             const char * output,        // Sorted file (may be
+                                         // the same as input)
+             const extsort_options * opt,  // NULL: defaults
+             extsort_stats * stats)        // Stats (or NULL)
+{
+    extsorter s;
+    extsort_stats st;
+    char name[NAME_MAX_LEN];
+    FILE * in;
+    double t0, t1, t2;
+    uint32_t i;
+
+    memset (&s, 0, sizeof(s));
+    memset (&st, 0, sizeof(st));
+
+    s.memory = opt && opt->memory ? opt->memory
+                                  : EXTSORT_DEFAULT_MEMORY;
+    s.kernel = opt && opt->kernel ? opt->kernel : quicksort;
+
+    if (s.memory < 4 * MIN_BUFFER)
+        s.memory = 4 * MIN_BUFFER;
+
+    if (snprintf (s.dir, sizeof(s.dir), "%s/extsort-XXXXXX",
+                  opt && opt->tmpdir ? opt->tmpdir : ".")
+        >= (int) sizeof(s.dir))
+    {
+        errno = ENAMETOOLONG;
+        return 0;
+    }
+
+    if (!mkdtemp (s.dir))
+        return 0;
+
+    in = open_file (&s, input, "rb");
+    if (!in)
+    {
+        rmdir (s.dir);
+        errno = s.err;
+        return 0;
+    }
+
+    if (!io_start (&s.io))
+    {
+        fail (&s);
+        fclose (in);
+        rmdir (s.dir);
+        errno = s.err ? s.err : EAGAIN;
+        return 0;
+    }
+
+    t0 = seconds ();
+
+    st.elements = make_runs (&s, in, output, &st.run_bytes);
+    st.runs = s.nextrun;
+
+    t1 = seconds ();
+
+    if (!s.error && s.nextrun > 0)
+        merge_phase (&s, output, &st);
+
+    t2 = seconds ();
+
+    io_stop (&s.io);
+
+    for (i=0; i<s.count; i++)                 // Remove the runs
+    {                                         // left after a
+        run_name (&s, s.runs[s.first + i], name);   // failure
+        remove (name);
+    }
+    free (s.runs);
+    rmdir (s.dir);
+                                              // Replace the output
+    if (s.tmpout[0])                          // (that may be the
+    {                                         // input) only if all
+        if (!s.error && rename (s.tmpout, output) != 0)   // went
+            fail (&s);                                    // well
+        if (s.error)
+            remove (s.tmpout);
+    }
+
+    st.run_seconds = t1 - t0;
+    st.merge_seconds = t2 - t1;
+
+    if (opt && opt->verbose)
+    {
+        fprintf (stderr, "extsort: runs: %lu runs, %.3f s, "
+                 "%.1f MB/s\n", (unsigned long) st.runs,
+                 st.run_seconds, st.run_bytes / 1e6 /
+                 (st.run_seconds > 0 ? st.run_seconds : 1));
+        fprintf (stderr, "extsort: merge: %lu merges, %.3f s, "
+                 "%.1f MB/s\n", (unsigned long) st.merges,
+                 st.merge_seconds, st.merge_bytes / 1e6 /
+                 (st.merge_seconds > 0 ? st.merge_seconds : 1));
+    }
+
+    if (stats)
+        *stats = st;
+
+    if (s.error)
+    {
+        errno = s.err ? s.err : EIO;
+        return 0;
+    }
+
+    return 1;
+}
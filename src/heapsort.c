@@ -5,7 +5,7 @@
     ---------------------------------------------------------------
     heapsort.c
     
-    Implementation of heap sort. There are two versions of
+    Implementation of heap sort. There are three versions of
     it in this file:
     
        1) The first one is the bare algorithm. It uses the same
@@ -25,68 +25,157 @@
           not necessary most of the times. This saves some
           comparisons in the way down. Though, note that this
           implementation always takes O(N log N) time
+
+       3) The third one is a "bottom-up" heap sort (as described
+          by Ingo Wegener) written without unpredictable branches.
+          With random data, the choice of the greater child is a
+          coin toss that the processor mispredicts half of the
+          times. Here, the child is chosen with arithmetic
+          (c += H[c] < H[c+1]) and the path of greater children
+          is followed down to a leaf without comparing with the
+          value to insert. Then, the place of that value in the
+          path is found with a branchless binary search, and
+          the path is shifted up to make room for it. The whole
+          path is rewritten, and the nodes below that place are
+          copied onto themselves, so the length of every loop
+          depends on the length of the path, not on the values.
+          Without branches to speculate on, the processor can't
+          load the next levels of the heap in advance, so the
+          sift prefetches the nodes log2(AHEAD) levels below (see
+          prefetch.h). It is in place too, and always O(N log N).
+          With random data, the benchmark (gcc -O2, x86-64) shows
+          it on par with the second version between 10^4 and 10^6
+          elements, within some 5% either way: the mispredictions
+          it saves are paid back with a longer path and chain of
+          dependent operations. How they balance depends on the
+          processor, so measure before choosing it. For very small
+          arrays it is slower
+
+    There is also partial_sort(), that only sorts the k smallest
+    elements of the array. It builds a max heap with the first k
+    elements and streams the rest through it: every element less
+    than the root replaces it and is pushed down with sift_in().
+    At the end, the heap holds the k smallest elements, and it is
+    sorted like in the first version. This takes O(N log k) time
+    instead of O(N log N)
+
+    heapsort_parallel() is the third version with a multithreaded
+    first phase. The subtrees rooted at a level with several
+    nodes per thread are disjoint, so they are turned into heaps
+    at the same time, in a work-stealing pool (see workpool.h).
+    Then the levels above them are finished serially. The second
+    phase can't be split: every extraction depends on the previous
+    one. So it is the same as in the third version, where the
+    prefetches hide most of the latency of large arrays. Arrays of
+    less than PARALLEL_MIN elements are sorted serially
+
+    All versions can be instrumented to count comparisons, moves
+    and levels traversed by the sift functions (see sortstats.h).
+
+    The three versions and their sift functions are written once,
+    in heapsort_kernel.h, shared with the templates of sorting.hpp
     ---------------------------------------------------------------
 */
 
-#include "sorting.h"
+#include <stdlib.h>
 
-static inline void sift_in (
-        sorteddatatype * H,     // Heap goes from H[1] to H[num]
-        uint32_t         num,   // Current size of the heap
-        uint32_t         i);    // Element to push down
+#include "sorting.h"
+#include "sortstats.h"
+#include "workpool.h"
 
-static inline void sift_in_floyd (
-        sorteddatatype * H,     // Heap goes from H[1] to H[num]
-        uint32_t         num,   // Current size of the heap
-        sorteddatatype   tmp);  // Value to be inserted
-                                // (Assume that H[1] is empty)
+#define PARALLEL_MIN      (1UL<<20)  // Sort smaller arrays serially
+#define TASKS_PER_THREAD  8          // Subtrees heapified per thread
 
-void heapsort (sorteddatatype A[],         // Array to be sorted
-               uint32_t num)               // Size of the array
+typedef struct
 {
-    sorteddatatype * H;   // We will access the array through H
-    sorteddatatype tmp;   // Temporary variable for swaps
-    uint32_t i;           // Next element to insert in the heap
+    sorteddatatype * H;       // Heap goes from H[1] to H[num]
+    uint32_t         num;
+    uint32_t         root;    // Root of the subtree to heapify
+}
+heaptask;
 
-    if (num < 2)
-        return;
-                   // Access the array as { H[1], ... H[num] }
-    H = A - 1;     // This way, the children of H[x] are
-                   // H[2*x] and H[2*x+1]
+#include "heapsort_kernel.h"
 
-    // 1st: HEAPIFY
-                              // Build a valid max heap by
-    for (i=num>>1; i; i--)    // pushing down the small elements
-        sift_in (H, num, i);  // of the first half of the array
-                              // in inverse order (H[1] last)
-    // 2nd: SORT
-                       // The variable 'num' will be used now
-    while (num > 1)    // as the size of the heap
-    {
-        tmp = H[num];       // Take the current max. from the
-        H[num] = H[1];      // root of the heap to H[num]
-        num --;
-        H[1] = tmp;            // Reinsert the old
-        sift_in (H, num, 1);   // H[num] into the heap
+static void heapify_subtree (void * arg)
+{
+    heaptask * t = (heaptask *) arg;
+    uint32_t lo, hi, i;      // Nodes of one level of the subtree
+    uint32_t last;           // Last node with children
+    int d;
+
+    last = t->num >> 1;
+
+    for (d=0; d<31 && ((uint64_t)t->root << (d+1)) <= last; d++)
+        ;                                 // Deepest level with
+                                          // children
+    for (; d>=0; d--)                     // From that level up to
+    {                                     // the root, push down
+        lo = t->root << d;                // every node (children
+        hi = ((t->root + 1) << d) - 1;    // before parents)
+        if (hi > last)
+            hi = last;
+
+        for (i=hi; i>=lo; i--)
+            sift_in_branchless (t->H, t->num, i, t->H[i]);
     }
 }
 
-void heapsort_floyd (sorteddatatype A[],   // Array to be sorted
-                     uint32_t num)         // Size of the array
-{
+void heapsort_parallel (sorteddatatype A[],  // Array to be sorted
+                        uint32_t num,        // Size of the array
+                        int nthreads)        // Threads (<1: one per
+{                                            // processor)
     sorteddatatype * H;
     sorteddatatype tmp;
-    uint32_t i;          // NOTE: See the comments of the
-                         //       previous function. This one
-    if (num < 2)         //       is nearly identical. The only
-        return;          //       difference is at the end
+    heaptask * tasks;
+    workpool * pool;
+    uint32_t i, first;   // The subtrees are rooted at H[first] to
+    int ntasks, t;       // H[2*first-1]
 
-    H = A - 1;
+    if (nthreads < 1)
+        nthreads = workpool_processors ();
+
+    if (nthreads < 2 || num < PARALLEL_MIN)
+    {
+        heapsort_branchless (A, num);
+        return;
+    }
+
+    if ((uint32_t)nthreads > (num>>10) / TASKS_PER_THREAD)  // So that
+        nthreads = (int) ((num>>10) / TASKS_PER_THREAD);    // every
+                                       // subtree has 512 nodes or more
+    H = A - 1;                         // (and 'first' can't overflow)
+
+    for (first=1; first < (uint32_t)nthreads*TASKS_PER_THREAD;
+         first<<=1)
+        ;
+
+    ntasks = (int) first;
+    tasks = malloc (ntasks * sizeof(heaptask));
+    pool = tasks ? workpool_create (nthreads) : NULL;
 
     // 1st: HEAPIFY
 
-    for (i=num>>1; i; i--)
-        sift_in (H, num, i);
+    if (pool)
+    {
+        for (t=0; t<ntasks; t++)          // The subtrees in
+        {                                 // parallel...
+            tasks[t].H = H;
+            tasks[t].num = num;
+            tasks[t].root = first + t;
+            workpool_submit (pool, heapify_subtree, tasks+t);
+        }
+        workpool_wait (pool);
+        workpool_destroy (pool);
+
+        i = first - 1;                    // ...and the levels above
+    }                                     // them serially
+    else
+        i = num >> 1;                     // Not enough memory or
+                                          // threads: all serially
+    for (; i; i--)
+        sift_in_branchless (H, num, i, H[i]);
+
+    free (tasks);
 
     // 2nd: SORT
 
@@ -94,79 +183,63 @@ void heapsort_floyd (sorteddatatype A[],   // Array to be sorted
     {
         tmp = H[num];
         H[num] = H[1];
-        num --;                       // Use optimized sift_in to
-        sift_in_floyd (H, num, tmp);  // reinsert the old H[num]
-    }                                 // into the heap
+        num --;
+        sift_in_branchless (H, num, 1, tmp);
+
+        STAT_READ (2);
+        STAT_WRITE (1);
+    }
 }
 
-static inline void sift_in (
-        sorteddatatype * H,     // Heap goes from H[1] to H[num]
-        uint32_t         num,   // Current size of the heap
-        uint32_t         i)     // Element to push down
+void partial_sort (sorteddatatype A[],     // Array to be sorted
+                   uint32_t num,           // Size of the array
+                   uint32_t k)             // Elements to sort
 {
-    sorteddatatype tmp;   // Temporary var. for chained swaps
-    uint32_t p, c;        // Pos. in the heap (parent and child)
-    
-    tmp = H[i];           // Save the value to push down
-    p = i;                // This is the current parent
-  
-    for (c=p<<1; c<num; c<<=1)   // While it has two children
+    sorteddatatype * H;
+    sorteddatatype tmp;
+    uint32_t i;
+
+    if (k > num)
+        k = num;
+
+    if (k < 1)
+        return;
+
+    H = A - 1;
+
+    // 1st: HEAPIFY THE FIRST k ELEMENTS
+
+    for (i=k>>1; i; i--)
+        sift_in (H, k, i);
+
+    // 2nd: STREAM THE REST THROUGH THE HEAP
+
+    for (i=k; i<num; i++)
     {
-        if (H[c] < H[c+1])       // Choose the child whith
-            c ++;                // greater value
-
-        if (H[c] <= tmp)         // If greater child is less/eq.
-            break;               // to the initial value, stop
-                                 // pushing down. Otherwise,
-        H[p] = H[c];             // move the child up and
-        p = c;                   // go down
-    }
-    
-    if (c == num && H[c] > tmp)  // If there is a final "only
-    {                            // child" greater than the
-        H[p] = H[c];             // initial value, move the
-        p = c;                   // child up and go down
+        STAT_READ (2);
+        STAT_CMP (1);
+
+        if (A[i] < H[1])        // If it is less than the max. of
+        {                       // the k smallest so far, swap
+            tmp = A[i];         // them and push it down
+            A[i] = H[1];
+            H[1] = tmp;
+            STAT_WRITE (2);
+            sift_in (H, k, 1);
+        }
     }
-                          // Put the saved value in the hole
-    H[p] = tmp;           // left by the last child moved up
-}
 
-static inline void sift_in_floyd (
-        sorteddatatype * H,     // Heap goes from H[1] to H[num]
-        uint32_t         num,   // Current size of the heap
-        sorteddatatype   tmp)   // Value to be inserted
-{                               // (Assume that H[1] is empty)
-
-    uint32_t p, c;        // Pos. in the heap (parent and child)
-  
-    p = 1;
-  
-    for (c=p<<1; c<num; c<<=1)   // While it has two children
-    {
-        if (H[c] < H[c+1])       // Choose the one with the
-            c ++;                // greater value
+    // 3rd: SORT THE HEAP
 
-        H[p] = H[c];             // Move the child up and
-        p = c;                   // go down
-    }
-  
-    if (c == num)                // If there is a final "only
-    {                            // child", move it up and
-        H[p] = H[c];             // go down
-        p = c;
-    }                            // Note that this travel down
-                                 // was done even if tmp had
-    for (;;)                     // a great value
+    while (k > 1)
     {
-        c = p;                      // Now, undo some of the
-        p >>= 1;                    // previous steps if
-                                    // necessary. This will
-        if (p == 0 || H[p] >= tmp)  // happen very few times.
-            break;                  // That's the key for the
-                                    // optimization
-        H[c] = H[p];
+        tmp = H[k];
+        H[k] = H[1];
+        k --;
+        H[1] = tmp;
+        sift_in (H, k, 1);
+
+        STAT_READ (2);
+        STAT_WRITE (2);
     }
-   
-    H[c] = tmp;         // Put the stored value in the hole
 }
-
@@ -0,0 +1,23 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    heapsort_64.c
+
+    Versions of heapsort(), heapsort_floyd() and
+    heapsort_branchless() for arrays of more than 4G elements.
+    The code is the same as in heapsort.c (see the comments
+    there): heapsort_kernel.h, included with KERNEL_64 defined
+    (see sortkernel.h), so the size of the array and the
+    positions in the heap are size_t values instead of uint32_t.
+
+    Note that heapsort.c is still preferable for smaller arrays,
+    since 32 bit indices are a bit cheaper on some platforms
+    ---------------------------------------------------------------
+*/
+
+#define KERNEL_64
+
+#include "sorting.h"
+#include "heapsort_kernel.h"
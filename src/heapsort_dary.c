@@ -0,0 +1,173 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    heapsort_dary.c
+
+    Implementation of heap sort with a d-ary heap (every node has
+    d children instead of 2). There are two versions of it in this
+    file, with d=4 and d=8, chosen at compile time: both use the
+    same functions with a constant arity, so the compiler unrolls
+    the selection of the greatest child.
+
+    The binary heap of heapsort.c touches a new cache line in
+    every level of a sift, once it is past the first few levels.
+    With large arrays that don't fit in the cache, it spends most
+    of its time waiting for memory. A d-ary heap has log2(d) times
+    less levels, and the children of a node are contiguous. The
+    layout used here keeps them aligned too:
+
+        A[0] is the root, with d-1 children: A[1] ... A[d-1]
+
+        The children of any other A[i] are A[d*i] ... A[d*i+d-1]
+
+    The siblings of every group start at a multiple of d, so if
+    the array is aligned to d*sizeof(sorteddatatype) bytes (32 for
+    d=4, 64 for d=8), they always share one cache line (half a
+    line for d=4). Besides, while the children of a node are
+    compared, the sift prefetches its grandchildren (see
+    prefetch.h), so that the next level is already on its way.
+
+    The price is more comparisons per level: d-1 to choose the
+    greatest child, plus one with the value sifted. Therefore,
+    these versions are slower than heapsort() for small arrays,
+    and faster for arrays much greater than the cache. With random
+    doubles, heapsort_4ary() overtakes heapsort() and
+    heapsort_floyd() at about 10^6 elements, and is around 15%
+    faster at 3*10^7. heapsort_8ary() needs larger arrays still,
+    because its 7 comparisons per level are rarely predictable
+    (run the benchmark to find the crossover in each machine)
+
+    Like heapsort(), these take O(N) time when all data are equal.
+    They can be instrumented too (see sortstats.h)
+    ---------------------------------------------------------------
+*/
+
+#include "sorting.h"
+#include "sortstats.h"
+#include "prefetch.h"
+
+#define LINE_ELEMS  (CACHE_LINE / sizeof(sorteddatatype))
+
+static inline void sift_in_dary (
+        sorteddatatype A[],     // Heap goes from A[0] to A[num-1]
+        uint32_t       num,     // Current size of the heap
+        uint32_t       p,       // Hole to fill (pushing down)
+        sorteddatatype tmp,     // Value to be inserted
+        uint32_t       d);      // Arity of the heap
+
+static inline void heapsort_dary (sorteddatatype A[],
+                                  uint32_t num, uint32_t d);
+
+void heapsort_4ary (sorteddatatype A[],    // Array to be sorted
+                    uint32_t num)          // Size of the array
+{
+    heapsort_dary (A, num, 4);
+}
+
+void heapsort_8ary (sorteddatatype A[],    // Array to be sorted
+                    uint32_t num)          // Size of the array
+{
+    heapsort_dary (A, num, 8);
+}
+
+static inline void heapsort_dary (sorteddatatype A[],
+                                  uint32_t num, uint32_t d)
+{
+    sorteddatatype tmp;   // Temporary variable for swaps
+    uint32_t i;           // Next element to insert in the heap
+
+    if (num < 2)
+        return;
+
+    // 1st: HEAPIFY
+                                      // Push down the elements
+    for (i=(num-1)/d+1; i--; )        // that have children, from
+        sift_in_dary (A, num, i, A[i], d);  // the parent of the
+                                      // last one to the root
+    // 2nd: SORT
+
+    while (num > 1)
+    {
+        num --;                     // Take the current max. from
+        tmp = A[num];               // the root to A[num], and
+        A[num] = A[0];              // reinsert the old A[num]
+                                    // into the heap
+        sift_in_dary (A, num, 0, tmp, d);
+
+        STAT_READ (2);
+        STAT_WRITE (1);
+    }
+}
+
+static inline void sift_in_dary (
+        sorteddatatype A[],     // Heap goes from A[0] to A[num-1]
+        uint32_t       num,     // Current size of the heap
+        uint32_t       p,       // Hole to fill (pushing down)
+        sorteddatatype tmp,     // Value to be inserted
+        uint32_t       d)       // Arity of the heap
+{
+    uint32_t full;        // Nodes before A[full] have all children
+    uint32_t c, m, k;     // First child, greatest one and counter
+    sorteddatatype max, v;
+
+    full = num / d;
+
+    while (p < full)                 // While it has all its children
+    {
+        c = d * p;
+
+        if (c + d <= full)                  // Prefetch the
+            for (k=0; k<d*d; k+=LINE_ELEMS) // grandchildren
+                PREFETCH (A + d*c + k);
+
+        m = p ? c : 1;             // Choose the child with the
+        max = A[m];                // greatest value (the root has
+                                   // no child in A[0]). Keeping
+        for (k=1; k<d; k++)        // it in a register lets the
+        {                          // compiler do this without
+            v = A[c+k];            // branches
+            m = max < v ? c+k : m;
+            max = max < v ? v : max;
+        }
+
+        STAT_READ (d);
+        STAT_CMP (d);
+
+        if (max <= tmp)            // If it is less/eq. to the
+            break;                 // value, stop pushing down.
+                                   // Otherwise, move the child up
+        A[p] = max;                // and go down
+        p = m;
+        STAT_WRITE (1);
+        STAT_LEVEL ();
+    }
+
+    if (p == full)                 // The last parent may have
+    {                              // only some of its children
+        c = p ? d * p : 1;         // (all of them leaves)
+
+        if (c < num)
+        {
+            for (m=c, k=c+1; k<num; k++)
+                if (A[m] < A[k])
+                    m = k;
+
+            STAT_READ (num-c);
+            STAT_CMP (num-c);
+
+            if (A[m] > tmp)
+            {
+                A[p] = A[m];
+                p = m;
+                STAT_WRITE (1);
+                STAT_LEVEL ();
+            }
+        }
+    }
+                          // Put the saved value in the hole
+    A[p] = tmp;           // left by the last child moved up
+    STAT_WRITE (1);
+    STAT_SIFT ();
+}
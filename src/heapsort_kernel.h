@@ -0,0 +1,312 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    heapsort_kernel.h
+
+    The three versions of heap sort described in heapsort.c, with
+    their sift functions: sift_in(), sift_in_floyd() and
+    sift_in_branchless(). This is not a regular header: heapsort.c
+    includes it once for 'sorteddatatype', heapsort_64.c once
+    more with KERNEL_64 (size_t positions, and the names ending
+    in _64), and sorting.hpp once per element type and comparison
+    (see sortkernel.h). heapsort_payload.c includes it with
+    KERNEL_PAYLOAD, so every move is done with its payload too.
+
+    The swaps are chained and done with MOVE(), so the elements
+    only need to be movable, except in heapsort_branchless(): it
+    keeps a copy of the old max. in H[1] as a sentinel, and copies
+    the nodes of the path below the place found onto themselves,
+    so its elements must be copyable. Arrays of elements larger
+    than a cache line are prefetched one element at a time
+    -------------------------------------------------------------
+*/
+
+#include "sortkernel.h"
+#include "sortstats.h"
+#include "prefetch.h"
+
+#define AHEAD  32   // The branchless sift prefetches the nodes
+                    // log2(AHEAD) levels below the current one
+#define LINE_ELEMS  (sizeof(sorteddatatype) < CACHE_LINE ?    \
+                     CACHE_LINE / sizeof(sorteddatatype) : 1)
+
+KERNEL_STATIC inline void sift_in (
+        sorteddatatype * H,     // Heap goes from H[1] to H[num]
+        sortindex        num,   // Current size of the heap
+        sortindex        i      // Element to push down
+        PAYLOAD_PARAMS)
+{
+    sorteddatatype tmp = MOVE (H[i]);   // Save the value to push
+    sortindex p, c;       // Pos. in the heap (parent and child)
+
+    PAYLOAD_SAVE (&H[i]);
+    p = i;                // This is the current parent
+    STAT_READ (1);
+
+    for (c=p<<1; c<num; c<<=1)   // While it has two children
+    {
+        STAT_READ (2);
+        STAT_CMP (2);
+
+        if (LESS (H[c], H[c+1])) // Choose the child whith
+            c ++;                // greater value
+
+        if (LESS_EQ (H[c], tmp)) // If greater child is less/eq.
+            break;               // to the initial value, stop
+                                 // pushing down. Otherwise,
+        H[p] = MOVE (H[c]);      // move the child up and
+        PAYLOAD_MOVE (&H[p], &H[c]);
+        p = c;                   // go down
+        STAT_WRITE (1);
+        STAT_LEVEL ();
+    }
+
+    if (c == num && (STAT_READ (1), STAT_CMP (1), LESS (tmp, H[c])))
+    {                            // If there is a final "only
+        H[p] = MOVE (H[c]);      // child" greater than the
+        PAYLOAD_MOVE (&H[p], &H[c]);
+        p = c;                   // initial value, move the
+        STAT_WRITE (1);          // child up and go down
+        STAT_LEVEL ();
+    }
+                          // Put the saved value in the hole
+    H[p] = MOVE (tmp);    // left by the last child moved up
+    PAYLOAD_LOAD (&H[p]);
+    STAT_WRITE (1);
+    STAT_SIFT ();
+}
+
+KERNEL_STATIC inline void sift_in_floyd (
+        sorteddatatype * H,     // Heap goes from H[1] to H[num]
+        sortindex        num,   // Current size of the heap
+        sorteddatatype   tmp    // Value to be inserted (its
+        PAYLOAD_PARAMS)         // payload saved, and H[1] empty)
+{
+    sortindex p, c;       // Pos. in the heap (parent and child)
+
+    p = 1;
+
+    for (c=p<<1; c<num; c<<=1)   // While it has two children
+    {
+        STAT_READ (2);
+        STAT_CMP (1);
+
+        if (LESS (H[c], H[c+1])) // Choose the one with the
+            c ++;                // greater value
+
+        H[p] = MOVE (H[c]);      // Move the child up and
+        PAYLOAD_MOVE (&H[p], &H[c]);
+        p = c;                   // go down
+        STAT_WRITE (1);
+        STAT_LEVEL ();
+    }
+
+    if (c == num)                // If there is a final "only
+    {                            // child", move it up and
+        H[p] = MOVE (H[c]);      // go down
+        PAYLOAD_MOVE (&H[p], &H[c]);
+        p = c;
+        STAT_READ (1);
+        STAT_WRITE (1);
+        STAT_LEVEL ();
+    }                            // Note that this travel down
+                                 // was done even if tmp had
+    for (;;)                     // a great value
+    {
+        c = p;                      // Now, undo some of the
+        p >>= 1;                    // previous steps if
+                                    // necessary. This will
+        if (p == 0 ||               // happen very few times.
+            (STAT_READ (1), STAT_CMP (1), LESS_EQ (tmp, H[p])))
+            break;                  // That's the key for the
+                                    // optimization
+        H[c] = MOVE (H[p]);
+        PAYLOAD_MOVE (&H[c], &H[p]);
+        STAT_WRITE (1);
+        STAT_LEVEL ();
+    }
+
+    H[c] = MOVE (tmp);  // Put the stored value in the hole
+    PAYLOAD_LOAD (&H[c]);
+    STAT_WRITE (1);
+    STAT_SIFT ();
+}
+
+KERNEL_STATIC inline void sift_in_branchless (
+        sorteddatatype * H,     // Heap goes from H[1] to H[num]
+        sortindex        num,   // Current size of the heap
+        sortindex        i,     // Hole to fill (pushing down)
+        sorteddatatype   tmp    // Value to be inserted (its
+        PAYLOAD_PARAMS)         // payload saved, H[i] >= tmp)
+{
+    sortindex j, c;       // Pos. in the heap (node and child)
+    sortindex lim;        // Nodes before H[lim] have two children
+    sortindex ahead;      // Nodes before H[ahead] prefetch
+    int len;              // Number of nodes in the path
+    int k, n, half;       // Binary search in the path
+
+    lim = num - (num >> 1);
+    ahead = num / AHEAD;
+
+    for (j=i, len=1; j<lim; len++)   // Go down to a leaf, always
+    {                                // through the greater child
+        if (j < ahead)                     // Prefetch the nodes
+            for (c=0; c<AHEAD; c+=LINE_ELEMS)  // some levels below
+                PREFETCH (H + AHEAD*j + c);
+        c = j << 1;
+        c += LESS (H[c], H[c+1]);    // (no branch here)
+        j = c;
+        STAT_READ (2);
+        STAT_CMP (1);
+        STAT_LEVEL ();
+    }
+
+    c = (sortindex)(j << 1) == num;   // A final "only child"
+    j = c ? num : j;
+    len += (int)c;
+                                     // The path is H[j>>k] for
+    k = 0;                           // k=len-1 (H[i]) to 0 (leaf),
+    n = len;                         // in decreasing order. Find
+                                     // the first k (the deepest
+    while (n > 1)                    // node) with H[j>>k] >= tmp.
+    {                                // There is one, since H[i]
+        half = n >> 1;               // is >= tmp
+        k = LESS (H[j >> (k+half)], tmp) ? k+half : k;
+        n -= half;
+        STAT_READ (1);
+        STAT_CMP (1);
+    }
+
+    k += LESS (H[j >> k], tmp);
+    STAT_READ (1);
+    STAT_CMP (1);
+
+    for (n=len-1; n>0; n--)          // Shift the path one level
+    {                                // up, from the hole down
+        H[j >> n] = H[j >> (n - (n>k))];  // to the place found
+        PAYLOAD_MOVE (&H[j >> n],         // (the nodes below it
+                      &H[j >> (n - (n>k))]);  // are copied onto
+    }                                         // themselves), and
+                                              // put the value there
+    H[j >> k] = MOVE (tmp);
+    PAYLOAD_LOAD (&H[j >> k]);
+    STAT_READ (len-1);
+    STAT_WRITE (len);
+    STAT_SIFT ();
+}
+
+void KERNEL(heapsort) (sorteddatatype A[], // Array to be sorted
+                       PAYLOAD_ARRAY       // (Payloads of A[])
+                       sortindex num)      // Size of the array
+{
+    sorteddatatype * H;   // We will access the array through H
+    sortindex i;          // Next element to insert in the heap
+    PAYLOAD_INIT
+
+    if (num < 2)
+        return;
+                   // Access the array as { H[1], ... H[num] }
+    H = A - 1;     // This way, the children of H[x] are
+                   // H[2*x] and H[2*x+1]
+
+    // 1st: HEAPIFY
+                              // Build a valid max heap by
+    for (i=num>>1; i; i--)    // pushing down the small elements
+        sift_in (H, num, i    // of the first half of the array
+                 PAYLOAD_ARGS);  // in inverse order (H[1] last)
+    // 2nd: SORT
+                       // The variable 'num' will be used now
+    while (num > 1)    // as the size of the heap
+    {
+        sorteddatatype tmp = MOVE (H[num]);   // Take the current
+        PAYLOAD_SAVE (&H[num]);               // max. from the root
+        H[num] = MOVE (H[1]);                 // of the heap to
+        PAYLOAD_MOVE (&H[num], &H[1]);        // H[num]
+        num --;
+
+        H[1] = MOVE (tmp);     // Reinsert the old
+        PAYLOAD_LOAD (&H[1]);  // H[num] into the heap
+        sift_in (H, num, 1 PAYLOAD_ARGS);
+
+        STAT_READ (2);
+        STAT_WRITE (2);
+    }
+}
+
+void KERNEL(heapsort_floyd) (
+                     sorteddatatype A[],   // Array to be sorted
+                     PAYLOAD_ARRAY         // (Payloads of A[])
+                     sortindex num)        // Size of the array
+{
+    sorteddatatype * H;
+    sortindex i;         // NOTE: See the comments of the
+    PAYLOAD_INIT         //       previous function. This one
+                         //       is nearly identical. The only
+    if (num < 2)         //       difference is at the end
+        return;
+
+    H = A - 1;
+
+    // 1st: HEAPIFY
+
+    for (i=num>>1; i; i--)
+        sift_in (H, num, i PAYLOAD_ARGS);
+
+    // 2nd: SORT
+
+    while (num > 1)
+    {
+        sorteddatatype tmp = MOVE (H[num]);
+        PAYLOAD_SAVE (&H[num]);
+        H[num] = MOVE (H[1]);
+        PAYLOAD_MOVE (&H[num], &H[1]);
+        num --;                           // Use optimized sift_in
+        sift_in_floyd (H, num, MOVE (tmp)    // to reinsert the old
+                       PAYLOAD_ARGS);        // H[num] into the heap
+        STAT_READ (2);
+        STAT_WRITE (1);
+    }
+}
+
+void KERNEL(heapsort_branchless) (
+                 sorteddatatype A[],       // Array to be sorted
+                 PAYLOAD_ARRAY             // (Payloads of A[])
+                 sortindex num)            // Size of the array
+{
+    sorteddatatype * H;
+    sortindex i;
+    PAYLOAD_INIT
+
+    if (num < 2)
+        return;
+
+    H = A - 1;
+
+    // 1st: HEAPIFY
+
+    for (i=num>>1; i; i--)
+    {
+        PAYLOAD_SAVE (&H[i]);
+        sift_in_branchless (H, num, i, H[i] PAYLOAD_ARGS);
+    }
+
+    // 2nd: SORT
+
+    while (num > 1)
+    {
+        sorteddatatype tmp = MOVE (H[num]);  // The old max. stays
+        PAYLOAD_SAVE (&H[num]);              // in H[1] too, where
+        H[num] = H[1];                       // it stops the search
+        PAYLOAD_MOVE (&H[num], &H[1]);       // of the place of tmp
+        num --;
+        sift_in_branchless (H, num, 1, MOVE (tmp) PAYLOAD_ARGS);
+
+        STAT_READ (2);
+        STAT_WRITE (1);
+    }
+}
+
+#undef AHEAD
+#undef LINE_ELEMS
@@ -0,0 +1,26 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    heapsort_payload.c
+
+    Versions of heapsort(), heapsort_floyd() and
+    heapsort_branchless() that sort an array of keys A[] and move
+    a parallel array of payloads P[] (e.g. row ids) in lock-step:
+    after the sort, P[i] is still the payload of A[i].
+
+    This is cheaper than sorting an array of structs {key, id},
+    because the comparisons only read the keys, which are packed
+    together. The payloads are only touched when an element
+    moves. The code is the same as in heapsort.c (see the
+    comments there): heapsort_kernel.h, included with
+    KERNEL_PAYLOAD defined, so that every move of a key is done
+    with its payload too (see sortkernel.h)
+    ---------------------------------------------------------------
+*/
+
+#define KERNEL_PAYLOAD
+
+#include "sorting.h"
+#include "heapsort_kernel.h"
@@ -0,0 +1,172 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    heapsort_weak.c
+
+    Implementation of weak-heap sort (Ronald D. Dutton, 1993). A
+    weak heap is a binary tree with looser rules than a heap:
+
+       - The root has only one child (the right one), and no
+         value in the tree is greater than the root
+
+       - Every other node is not less than any value in its
+         right subtree. Its left subtree is not constrained
+
+    Every element A[i] has a "reverse" bit r[i] that swaps its two
+    children: they are A[2i+r[i]] (left) and A[2i+1-r[i]] (right).
+    Flipping r[i] turns the left subtree into the right one at the
+    cost of one bit, with no moves. Thus, two weak heaps (a node
+    and its left subtree) are joined with one comparison: if the
+    root of the subtree is greater, the two roots are swapped and
+    the reverse bit of the subtree is flipped.
+
+    The ancestor of A[j] that must be not less than it (its
+    "distinguished ancestor") is the parent of the first node,
+    going up from A[j], that is a right child. So the array is
+    turned into a weak heap with N-1 joins, from the last element
+    to the first one.
+
+    To sort, the maximum is swapped with the last element, and
+    the new root is restored going down the path of left children
+    from A[1] to the bottom and then joining the root with every
+    node of that path, bottom-up. This takes at most ceil(log2 N)
+    comparisons, and none is spent choosing a child. In total,
+    weak-heap sort does less than N log2 N + 0.1 N comparisons in
+    the worst case. With random data, it does about N log2 N -
+    0.45 N, while heapsort_floyd() does about N log2 N + 0.6 N and
+    heapsort() about 2 N log2 N. So it is the heap sort of choice
+    when comparing keys costs much more than moving them. With
+    doubles, the bit manipulation and the longer chain of
+    dependent loads make it slower than heapsort_floyd().
+
+    It needs N extra bits for the reverse bits. If they can't be
+    allocated, it falls back to heapsort_floyd(). Like the other
+    versions, it always takes O(N log N) time, and it can be
+    instrumented (see sortstats.h)
+    ---------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+
+#include "sorting.h"
+#include "sortstats.h"
+
+#define REV(r,i)   (((r)[(i)>>5] >> ((i)&31)) & 1)    // Reverse bit
+#define FLIP(r,i)  ((r)[(i)>>5] ^= 1UL << ((i)&31))   // of A[i]
+
+static inline uint32_t ancestor (const uint32_t r[], uint32_t j);
+
+static inline void join (sorteddatatype A[], uint32_t r[],
+                         uint32_t i, uint32_t j);
+
+static inline void sift_in_weak (sorteddatatype A[], uint32_t r[],
+                                 uint32_t num);
+
+void heapsort_weak (sorteddatatype A[],    // Array to be sorted
+                    uint32_t num)          // Size of the array
+{
+    uint32_t * r;         // Reverse bits
+    sorteddatatype tmp;   // Temporary variable for swaps
+    uint32_t i;
+
+    if (num < 2)
+        return;
+
+    r = calloc ((num>>5) + 1, sizeof(uint32_t));
+
+    if (!r)                        // Not enough memory: use
+    {                              // the in-place version with
+        heapsort_floyd (A, num);   // the least comparisons
+        return;
+    }
+
+    // 1st: HEAPIFY
+
+    for (i=num-1; i; i--)
+        join (A, r, ancestor (r, i), i);
+
+    // 2nd: SORT
+
+    for (i=num-1; i>1; i--)
+    {
+        tmp = A[i];              // Move the max. to the end and
+        A[i] = A[0];             // restore the rest of the heap
+        A[0] = tmp;
+        STAT_READ (2);
+        STAT_WRITE (2);
+
+        sift_in_weak (A, r, i);
+    }
+
+    tmp = A[1];                  // Only two remain. A[0] is the
+    A[1] = A[0];                 // greater one
+    A[0] = tmp;
+    STAT_READ (2);
+    STAT_WRITE (2);
+
+    free (r);
+}
+
+static inline uint32_t ancestor (const uint32_t r[], uint32_t j)
+{
+    while ((j&1) == REV (r, j>>1))  // While A[j] is a left child,
+        j >>= 1;                    // go up
+
+    return j >> 1;               // The parent of a right child
+}
+
+static inline void join (sorteddatatype A[], uint32_t r[],
+                         uint32_t i, uint32_t j)
+{
+    sorteddatatype tmp;
+
+    STAT_READ (2);
+    STAT_CMP (1);
+
+    if (A[i] < A[j])       // If the root of the subtree is the
+    {                      // greater one, swap the roots and
+        tmp = A[i];        // flip the subtree
+        A[i] = A[j];
+        A[j] = tmp;
+        FLIP (r, j);
+        STAT_WRITE (2);
+    }
+}
+
+static inline void sift_in_weak (
+        sorteddatatype A[],     // Heap goes from A[0] to A[num-1]
+        uint32_t       r[],     // Reverse bits
+        uint32_t       num)     // Current size of the heap
+{
+    sorteddatatype tmp;   // Value at the root
+    sorteddatatype t;     // Temporary variable for swaps
+    uint64_t y;           // (2*x may not fit in 32 bits)
+    uint32_t x;
+
+    for (x=1; (y = 2ULL*x + REV (r, x)) < num; x=(uint32_t)y)
+        STAT_LEVEL ();               // Go down the left children
+
+    tmp = A[0];
+    STAT_READ (1);
+
+    for (; x; x>>=1)             // Join the root with every node
+    {                            // of the path, bottom-up. The
+        STAT_READ (1);           // root stays in 'tmp'
+        STAT_CMP (1);
+
+        if (tmp < A[x])
+        {
+            t = A[x];
+            A[x] = tmp;
+            tmp = t;
+            FLIP (r, x);
+            STAT_WRITE (1);
+        }
+    }
+
+    A[0] = tmp;
+    STAT_WRITE (1);
+    STAT_SIFT ();
+}
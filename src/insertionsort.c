@@ -0,0 +1,50 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    insertionsort.c
+
+    Implementation of insertion sort. There are four versions of
+    it in this file:
+
+       1) The bare algorithm: every element is swapped with the
+          previous one while it is less than it
+
+       2) The same with the chained swaps optimization (see
+          doc/en/ChainedSwapsOptimization.md): the element is
+          saved, the greater ones are moved one step to the right
+          and the element is written in the hole left by them
+
+       3) The place of every element is found with a binary
+          search, so it takes O(N log N) comparisons. The greater
+          elements are moved with a single memmove(), that copies
+          whole blocks with vector instructions. The moves are
+          still O(N^2), but much cheaper
+
+       4) Like the third one, but the search is biased towards
+          the end of the sorted part, where the element already
+          is: it gallops backwards from there in steps of 1, 2,
+          4, 8... and then does a binary search in the last step.
+          An element that goes d positions back takes O(log d)
+          comparisons, so nearly sorted data take O(N) time, and
+          random data take about twice the comparisons of the
+          third version
+
+    All of them are stable and take O(N) time with sorted data.
+    They are the usual choice for small arrays (up to a few dozen
+    elements) and for the small pieces left by other algorithms.
+
+    For the latter, every version has a "_from" form that takes
+    the position of the first element to insert. The elements
+    before it must be sorted already (e.g. a run found by a merge
+    sort). Pass A+lo and hi-lo to sort just A[lo..hi).
+
+    They can be instrumented (see sortstats.h). They are written
+    once, in insertionsort_kernel.h, shared with the templates of
+    sorting.hpp
+    ---------------------------------------------------------------
+*/
+
+#include "sorting.h"
+#include "insertionsort_kernel.h"
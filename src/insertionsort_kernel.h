@@ -0,0 +1,189 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    insertionsort_kernel.h
+
+    The four versions of insertion sort described in
+    insertionsort.c, and their "_from" forms. This is not a
+    regular header: insertionsort.c includes it once for
+    'sorteddatatype', and sorting.hpp once per element type and
+    comparison (see sortkernel.h).
+
+    The searches compare with the element in the array, and it
+    is only moved out when it has to go somewhere else, so the
+    elements only need to be movable
+    -------------------------------------------------------------
+*/
+
+#include "sortkernel.h"
+#include "sortstats.h"
+
+KERNEL_STATIC inline uint32_t upper_bound (
+                                    const sorteddatatype * key,
+                                    const sorteddatatype A[],
+                                    uint32_t lo, uint32_t hi)
+{
+    uint32_t m;              // Position of the first element of
+                             // A[lo..hi) greater than key (or hi).
+    while (lo < hi)          // Going after the equal ones keeps
+    {                        // the sort stable
+        m = lo + ((hi - lo) >> 1);
+        STAT_READ (1);
+        STAT_CMP (1);
+
+        if (LESS (*key, A[m]))
+            hi = m;
+        else
+            lo = m + 1;
+    }
+
+    return lo;
+}
+
+void insertionsort_simple_from (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num,             // Size of the array
+                 uint32_t start)           // A[0..start) is sorted
+{
+    uint32_t i, j;
+
+    for (i=start; i<num; i++)
+        for (j=i; j && (STAT_READ (2), STAT_CMP (1),
+                        LESS (A[j], A[j-1])); j--)
+        {
+            sorteddatatype tmp = MOVE (A[j]);   // Swap it with the
+            A[j] = MOVE (A[j-1]);               // previous one
+            A[j-1] = MOVE (tmp);
+            STAT_WRITE (2);
+        }
+}
+
+void insertionsort_chained_swaps_from (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num,             // Size of the array
+                 uint32_t start)           // A[0..start) is sorted
+{
+    uint32_t i, j;
+
+    for (i=start; i<num; i++)
+    {
+        sorteddatatype tmp = MOVE (A[i]);   // Move greater values
+        STAT_READ (1);                      // one step to the
+                                            // right with chained
+        for (j=i; j && (STAT_READ (1), STAT_CMP (1), LESS (tmp, A[j-1]));
+             j--)                           // swaps, and put the
+        {                                   // value in the hole
+            A[j] = MOVE (A[j-1]);
+            STAT_WRITE (1);
+        }
+
+        A[j] = MOVE (tmp);
+        STAT_WRITE (1);
+    }
+}
+
+void insertionsort_binary_search_from (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num,             // Size of the array
+                 uint32_t start)           // A[0..start) is sorted
+{
+    uint32_t i, p;        // Element to insert and its place
+
+    for (i=start; i<num; i++)
+    {
+        STAT_READ (1);
+
+        p = upper_bound (A+i, A, 0, i);
+
+        if (p < i)                            // Shift the greater
+        {                                     // ones in one block
+            sorteddatatype tmp = MOVE (A[i]);
+            MOVE_RIGHT (A+p+1, A+p, i-p);
+            A[p] = MOVE (tmp);
+            STAT_READ (i-p);
+            STAT_WRITE (i-p+1);
+        }
+    }
+}
+
+void insertionsort_biased_binary_search_from (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num,             // Size of the array
+                 uint32_t start)           // A[0..start) is sorted
+{
+    uint32_t i, p;        // Element to insert and its place
+    uint32_t lo, hi;      // Range of the final binary search
+    uint32_t step;
+
+    for (i=start; i<num; i++)
+    {
+        STAT_READ (2);
+        STAT_CMP (1);
+                                      // Already in place (the usual
+        if (!i || !LESS (A[i], A[i-1]))   // case with nearly sorted
+            continue;                     // data)
+
+        hi = i - 1;                   // Gallop backwards. A[hi] is
+        step = 1;                     // always greater than A[i]
+
+        for (;;)
+        {
+            if (step >= hi)                  // Reached the beginning
+            {
+                lo = 0;
+                break;
+            }
+
+            lo = hi - step;
+            STAT_READ (1);
+            STAT_CMP (1);
+
+            if (!LESS (A[i], A[lo]))         // A[lo] <= A[i]: it goes
+            {                                // in (lo,hi]
+                lo ++;
+                break;
+            }
+
+            hi = lo;
+            step <<= 1;
+        }
+
+        p = upper_bound (A+i, A, lo, hi);
+
+        sorteddatatype tmp = MOVE (A[i]);
+        MOVE_RIGHT (A+p+1, A+p, i-p);
+        A[p] = MOVE (tmp);
+        STAT_READ (i-p);
+        STAT_WRITE (i-p+1);
+    }
+}
+
+void insertionsort_simple (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num)             // Size of the array
+{
+    insertionsort_simple_from (A, num, 1);
+}
+
+void insertionsort_chained_swaps (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num)             // Size of the array
+{
+    insertionsort_chained_swaps_from (A, num, 1);
+}
+
+void insertionsort_binary_search (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num)             // Size of the array
+{
+    insertionsort_binary_search_from (A, num, 1);
+}
+
+void insertionsort_biased_binary_search (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num)             // Size of the array
+{
+    insertionsort_biased_binary_search_from (A, num, 1);
+}
@@ -0,0 +1,48 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    mergesort.c
+
+    Implementation of a natural merge sort, in the way of Tim
+    Peters' "TimSort". It is the only O(N log N) stable sort of
+    this library (see doc/en/StableSort.md), and it is adaptive:
+    it takes O(N) time for sorted or reversed data, and close to
+    that for data that are nearly sorted.
+
+       1) The array is split in "runs": sequences that are already
+          ascending (a[i] <= a[i+1]) or strictly descending (a[i]
+          > a[i+1]). The latter are reversed, which can't break
+          the stability since they have no equal elements. Runs
+          shorter than MINRUN (a value between 32 and 64 chosen so
+          that the number of runs is close to a power of 2) are
+          extended with a binary insertion sort (see
+          insertionsort.c)
+
+       2) The runs are pushed in a stack, and merged while their
+          lengths don't decrease fast enough (every length must be
+          greater than the sum of the next two). This keeps the
+          merges balanced and the stack short (MAX_RUNS entries
+          are enough for 2^32 elements)
+
+       3) Every merge skips the elements that are already in
+          place at both ends, with an exponential ("galloping")
+          search. Then it copies the shorter run to the scratch
+          buffer and merges from it. When one of the runs wins
+          many times in a row, the merge switches to galloping
+          too, copying whole blocks at a time. The threshold
+          adapts to the data
+
+    mergesort_natural() allocates the scratch buffer as it needs
+    it. mergesort_natural_buffer() takes it from the caller, with
+    room for num/2 elements. If the allocation fails, the runs are
+    merged in place with rotations (still stable, but slower).
+
+    The code is in mergesort_kernel.h, shared with the templates
+    of sorting.hpp
+    ---------------------------------------------------------------
+*/
+
+#include "sorting.h"
+#include "mergesort_kernel.h"
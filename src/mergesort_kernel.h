@@ -0,0 +1,580 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    mergesort_kernel.h
+
+    The natural merge sort described in mergesort.c. This is not
+    a regular header: mergesort.c includes it once for
+    'sorteddatatype', and sorting.hpp once per element type and
+    comparison (see sortkernel.h). The includer must provide
+    insertionsort_binary_search_from() too (sorting.h declares
+    it, and sorting.hpp includes insertionsort_kernel.h before
+    this one).
+
+    The scratch buffer is raw memory. Every merge moves the
+    shorter run into it (constructing the elements there), and
+    destroys them when it's done, so the elements only need to
+    be movable, and the caller's buffer must have no elements
+    constructed in it.
+
+    With SORTING_STATS (see sortstats.h), the comparisons, reads
+    and writes of the whole sort are counted: the runs, the
+    gallops and the merges, not only the insertion sort. A block
+    moved to or from the scratch buffer counts as one read and
+    one write per element
+    -------------------------------------------------------------
+*/
+
+#include "sortkernel.h"
+#include "sortstats.h"
+
+#define MIN_GALLOP   7    // Initial threshold to start galloping
+#define MAX_RUNS    64    // Max. runs waiting in the stack
+
+typedef struct
+{
+    sorteddatatype * A;        // Array to be sorted
+    uint32_t   num;            // Size of the array
+    sorteddatatype * tmp;      // Scratch buffer
+    uint32_t   tmpsize;        // Size of the scratch buffer
+    int        owned;          // Was it allocated here?
+    int        mingallop;      // Current galloping threshold
+    int        nruns;          // Runs in the stack
+    uint32_t   base[MAX_RUNS]; // First position of every run
+    uint32_t   len[MAX_RUNS];  // Length of every run
+}
+mergestate;
+
+KERNEL_STATIC inline uint32_t min_run (uint32_t n)
+{
+    uint32_t r;           // Some bit shifted out was set
+
+    for (r=0; n>=64; n>>=1)    // Take the 6 most significant
+        r |= n & 1;            // bits, and add 1 if any of the
+                               // rest was set
+    return n + r;
+}
+
+KERNEL_STATIC inline void reverse (sorteddatatype A[], uint32_t num)
+{
+    uint32_t i, j;
+
+    for (i=0, j=num-1; i<j; i++, j--)
+    {
+        sorteddatatype tmp = MOVE (A[i]);
+        A[i] = MOVE (A[j]);
+        A[j] = MOVE (tmp);
+        STAT_READ (2);
+        STAT_WRITE (2);
+    }
+}
+
+KERNEL_STATIC uint32_t count_run (sorteddatatype A[], uint32_t num)
+{
+    uint32_t n;
+
+    if (num < 2)
+        return num;
+
+    STAT_READ (2);
+    STAT_CMP (1);
+
+    if (LESS (A[1], A[0]))               // Strictly descending:
+    {                                    // reverse it
+        for (n=2; n<num && (STAT_READ (1), STAT_CMP (1),
+                            LESS (A[n], A[n-1])); n++)
+            ;
+        reverse (A, n);
+    }
+    else                                 // Ascending
+        for (n=2; n<num && (STAT_READ (1), STAT_CMP (1),
+                            !LESS (A[n], A[n-1])); n++)
+            ;
+
+    return n;
+}
+
+KERNEL_STATIC uint32_t gallop (
+        const sorteddatatype * key,  // Value to place
+        const sorteddatatype   a[],  // Sorted array
+        uint32_t               n,    // Size of the array
+        uint32_t               hint, // Position to start from
+        int                    right)  // 0: before the equal ones
+{                                      // 1: after the equal ones
+    int64_t lastofs, ofs, maxofs, m;
+
+    STAT_READ (1);            // The key
+
+#define BEFORE(x)  (STAT_READ (1), STAT_CMP (1),                 \
+                    right ? !LESS (*key, (x)) : LESS ((x), *key))
+
+    lastofs = 0;              // Returns the number of elements
+    ofs = 1;                  // that go before the key. Search
+                              // in steps of 1, 3, 7, 15... from
+    if (BEFORE (a[hint]))     // the hint, and then do a binary
+    {                         // search in the last step
+        maxofs = (int64_t)n - hint;
+        while (ofs < maxofs && BEFORE (a[hint+ofs]))
+        {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs)
+            ofs = maxofs;
+        lastofs += hint;
+        ofs += hint;
+    }
+    else
+    {
+        maxofs = (int64_t)hint + 1;
+        while (ofs < maxofs && !BEFORE (a[hint-ofs]))
+        {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs)
+            ofs = maxofs;
+        m = lastofs;
+        lastofs = (int64_t)hint - ofs;
+        ofs = (int64_t)hint - m;
+    }
+                              // Now a[lastofs] goes before the
+    lastofs ++;               // key and a[ofs] doesn't (ignoring
+                              // the positions out of the array)
+    while (lastofs < ofs)
+    {
+        m = lastofs + ((ofs - lastofs) >> 1);
+        if (BEFORE (a[m]))
+            lastofs = m + 1;
+        else
+            ofs = m;
+    }
+
+#undef BEFORE
+
+    return (uint32_t) ofs;
+}
+
+KERNEL_STATIC int get_tmp (mergestate * ms, uint32_t need)
+{
+    uint32_t size;
+
+    if (ms->tmpsize >= need)
+        return 1;
+
+    if (!ms->owned && ms->tmp)           // The caller's buffer is
+        return 0;                        // too small
+
+    size = need < ms->num/4 ? ms->tmpsize*2 : ms->num/2;
+    if (size < need)
+        size = need;
+
+    BUF_FREE (ms->tmp);                  // Grow it, but never more
+    ms->tmp = (sorteddatatype *) BUF_ALLOC (size);  // than num/2
+    ms->tmpsize = ms->tmp ? size : 0;
+    ms->owned = 1;
+
+    return ms->tmp != NULL;
+}
+
+KERNEL_STATIC int merge_lo (mergestate * ms, sorteddatatype a[],
+                            uint32_t na, uint32_t nb)
+{
+    sorteddatatype * t, * b, * dest;     // Merge from the left,
+    uint32_t ca, cb, nt;                 // with the first run in
+    int mingallop;                       // the scratch buffer
+
+    if (!get_tmp (ms, na))
+        return 0;
+
+    t = ms->tmp;
+    nt = na;
+    BUF_FILL (t, a, na);
+    STAT_READ (na);
+    STAT_WRITE (na);
+    b = a + na;
+    dest = a;
+    mingallop = ms->mingallop;
+
+    while (na && nb)
+    {
+        ca = cb = 0;                     // One element at a time,
+                                         // counting the wins
+        for (;;)
+        {
+            STAT_READ (2);
+            STAT_CMP (1);
+            STAT_WRITE (1);
+
+            if (LESS (*b, *t))
+            {
+                *dest++ = MOVE (*b++);
+                nb --;
+                cb ++;
+                ca = 0;
+                if (!nb || (int)cb >= mingallop)
+                    break;
+            }
+            else
+            {
+                *dest++ = MOVE (*t++);
+                na --;
+                ca ++;
+                cb = 0;
+                if (!na || (int)ca >= mingallop)
+                    break;
+            }
+        }
+
+        if (!na || !nb)
+            break;
+
+        mingallop ++;                    // One run is winning
+        do                               // often. Gallop while
+        {                                // it pays
+            mingallop -= mingallop > 1;
+
+            ca = gallop (b, t, na, 0, 1);
+            MOVE_LEFT (dest, t, ca);
+            STAT_READ (ca);
+            STAT_WRITE (ca);
+            dest += ca;
+            t += ca;
+            na -= ca;
+            if (!na)
+                goto done;
+
+            *dest++ = MOVE (*b++);
+            STAT_READ (1);
+            STAT_WRITE (1);
+            if (!--nb)
+                goto done;
+
+            cb = gallop (t, b, nb, 0, 0);
+            MOVE_LEFT (dest, b, cb);
+            STAT_READ (cb);
+            STAT_WRITE (cb);
+            dest += cb;
+            b += cb;
+            nb -= cb;
+            if (!nb)
+                goto done;
+
+            *dest++ = MOVE (*t++);
+            STAT_READ (1);
+            STAT_WRITE (1);
+            if (!--na)
+                goto done;
+        }
+        while (ca >= MIN_GALLOP || cb >= MIN_GALLOP);
+
+        mingallop ++;                    // Penalty for leaving
+    }                                    // the galloping mode
+done:
+    ms->mingallop = mingallop < 1 ? 1 : mingallop;
+                                         // The rest of the second
+    MOVE_LEFT (dest, t, na);             // run is already in place
+    STAT_READ (na);
+    STAT_WRITE (na);
+    BUF_CLEAR (ms->tmp, nt);
+    return 1;
+}
+
+KERNEL_STATIC int merge_hi (mergestate * ms, sorteddatatype a[],
+                            uint32_t na, uint32_t nb)
+{
+    sorteddatatype * t, * pa, * pt, * dest;   // Merge from the
+    uint32_t ca, cb, nt;                      // right, with the
+    int mingallop;                            // second run in the
+                                              // scratch buffer
+    if (!get_tmp (ms, nb))
+        return 0;
+
+    t = ms->tmp;
+    nt = nb;
+    BUF_FILL (t, a+na, nb);
+    STAT_READ (nb);
+    STAT_WRITE (nb);
+    pa = a + na - 1;
+    pt = t + nb - 1;
+    dest = a + na + nb - 1;
+    mingallop = ms->mingallop;
+
+    while (na && nb)
+    {
+        ca = cb = 0;
+
+        for (;;)
+        {
+            STAT_READ (2);
+            STAT_CMP (1);
+            STAT_WRITE (1);
+
+            if (LESS (*pt, *pa))
+            {
+                *dest-- = MOVE (*pa--);
+                na --;
+                ca ++;
+                cb = 0;
+                if (!na || (int)ca >= mingallop)
+                    break;
+            }
+            else
+            {
+                *dest-- = MOVE (*pt--);
+                nb --;
+                cb ++;
+                ca = 0;
+                if (!nb || (int)cb >= mingallop)
+                    break;
+            }
+        }
+
+        if (!na || !nb)
+            break;
+
+        mingallop ++;
+        do
+        {
+            mingallop -= mingallop > 1;
+
+            ca = na - gallop (pt, a, na, na-1, 1);
+            dest -= ca;
+            pa -= ca;
+            MOVE_RIGHT (dest+1, pa+1, ca);
+            STAT_READ (ca);
+            STAT_WRITE (ca);
+            na -= ca;
+            if (!na)
+                goto done;
+
+            *dest-- = MOVE (*pt--);
+            STAT_READ (1);
+            STAT_WRITE (1);
+            if (!--nb)
+                goto done;
+
+            cb = nb - gallop (pa, t, nb, nb-1, 0);
+            dest -= cb;
+            pt -= cb;
+            MOVE_LEFT (dest+1, pt+1, cb);
+            STAT_READ (cb);
+            STAT_WRITE (cb);
+            nb -= cb;
+            if (!nb)
+                goto done;
+
+            *dest-- = MOVE (*pa--);
+            STAT_READ (1);
+            STAT_WRITE (1);
+            if (!--na)
+                goto done;
+        }
+        while (ca >= MIN_GALLOP || cb >= MIN_GALLOP);
+
+        mingallop ++;
+    }
+done:
+    ms->mingallop = mingallop < 1 ? 1 : mingallop;
+                                         // The rest of the first
+    MOVE_LEFT (dest+1-nb, t, nb);        // run is already in place
+    STAT_READ (nb);
+    STAT_WRITE (nb);
+    BUF_CLEAR (ms->tmp, nt);
+    return 1;
+}
+
+KERNEL_STATIC void rotate (sorteddatatype A[], uint32_t na, uint32_t nb)
+{
+    reverse (A, na);                      // Swap the blocks A[0..na)
+    reverse (A+na, nb);                   // and A[na..na+nb) with
+    reverse (A, na+nb);                   // three reversals
+}
+
+KERNEL_STATIC void merge_in_place (sorteddatatype A[],
+                                   uint32_t na, uint32_t nb)
+{
+    uint32_t i, j, lo, hi, m;
+                                  // Split the larger run in halves,
+    while (na && nb)              // find where its middle element
+    {                             // goes in the other run, and
+        if (na + nb == 2)         // rotate the blocks in between.
+        {                         // Then merge both sides the same
+            STAT_READ (2);        // way (the smaller one
+            STAT_CMP (1);         // recursively)
+            if (LESS (A[1], A[0]))
+                rotate (A, 1, 1);
+            return;
+        }
+
+        if (na >= nb)
+        {
+            i = na >> 1;                  // Elements of the second
+            for (lo=0, hi=nb; lo<hi; )    // run < A[i]
+            {
+                m = lo + ((hi - lo) >> 1);
+                STAT_READ (2);
+                STAT_CMP (1);
+                if (LESS (A[na+m], A[i]))
+                    lo = m + 1;
+                else
+                    hi = m;
+            }
+            j = lo;
+        }
+        else
+        {
+            j = nb >> 1;                  // Elements of the first
+            for (lo=0, hi=na; lo<hi; )    // run <= A[na+j]
+            {
+                m = lo + ((hi - lo) >> 1);
+                STAT_READ (2);
+                STAT_CMP (1);
+                if (LESS (A[na+j], A[m]))
+                    hi = m;
+                else
+                    lo = m + 1;
+            }
+            i = lo;
+        }
+
+        if (na-i && j)
+            rotate (A+i, na-i, j);
+
+        if (i + j < (na-i) + (nb-j))
+        {
+            merge_in_place (A, i, j);
+            A += i + j;
+            na -= i;
+            nb -= j;
+        }
+        else
+        {
+            merge_in_place (A+i+j, na-i, nb-j);
+            na = i;
+            nb = j;
+        }
+    }
+}
+
+KERNEL_STATIC void merge_at (mergestate * ms, int i)
+{
+    sorteddatatype * a;
+    uint32_t na, nb, k;
+
+    a = ms->A + ms->base[i];
+    na = ms->len[i];
+    nb = ms->len[i+1];
+
+    ms->len[i] = na + nb;           // Record the merged run. If
+    if (i == ms->nruns - 3)         // these are the 2nd and 3rd
+    {                               // from the top, the top one
+        ms->base[i+1] = ms->base[i+2];  // moves down
+        ms->len[i+1] = ms->len[i+2];
+    }
+    ms->nruns --;
+                                    // The elements of the first
+    k = gallop (a+na, a, na, 0, 1);     // run that are <= the
+    a += k;                             // first one of the second
+    na -= k;                            // are already in place
+    if (!na)
+        return;
+                                    // The same with the elements
+    nb = gallop (a+na-1, a+na, nb, nb-1, 0);    // of the second
+    if (!nb)                                    // run that are >=
+        return;                                 // the last of the
+                                                // first
+    if (na <= nb ? !merge_lo (ms, a, na, nb)
+                 : !merge_hi (ms, a, na, nb))
+        merge_in_place (a, na, nb);     // No memory
+}
+
+KERNEL_STATIC void merge_collapse (mergestate * ms)
+{
+    uint32_t * len = ms->len;
+    int n;
+                                // Merge until every run is longer
+    while (ms->nruns > 1)       // than the next two together, and
+    {                           // than the next one (checking the
+        n = ms->nruns - 2;      // three top runs, as corrected by
+                                // de Gouw et al. in 2015)
+        if ((n > 0 && len[n-1] <= len[n] + len[n+1]) ||
+            (n > 1 && len[n-2] <= len[n-1] + len[n]))
+        {
+            if (len[n-1] < len[n+1])
+                n --;
+        }
+        else if (len[n] > len[n+1])
+            break;
+
+        merge_at (ms, n);
+    }
+}
+
+KERNEL_STATIC void merge_force_collapse (mergestate * ms)
+{
+    int n;
+
+    while (ms->nruns > 1)
+    {
+        n = ms->nruns - 2;
+        if (n > 0 && ms->len[n-1] < ms->len[n+1])
+            n --;
+        merge_at (ms, n);
+    }
+}
+
+void mergesort_natural_buffer (
+                sorteddatatype A[],        // Array to be sorted
+                uint32_t num,              // Size of the array
+                sorteddatatype B[])        // Scratch buffer of
+{                                          // num/2 elements (or
+    mergestate ms;                         // NULL to allocate it)
+    uint32_t lo, rest, n, minrun;
+
+    if (num < 2)
+        return;
+
+    ms.A = A;
+    ms.num = num;
+    ms.tmp = B;
+    ms.tmpsize = B ? num/2 : 0;
+    ms.owned = 0;
+    ms.mingallop = MIN_GALLOP;
+    ms.nruns = 0;
+
+    minrun = min_run (num);
+
+    for (lo=0, rest=num; rest; lo+=n, rest-=n)
+    {
+        n = count_run (A+lo, rest);
+
+        if (n < minrun)                   // Extend short runs
+        {
+            insertionsort_binary_search_from (
+                        A+lo, rest < minrun ? rest : minrun, n);
+            n = rest < minrun ? rest : minrun;
+        }
+
+        ms.base[ms.nruns] = lo;           // Push the run and merge
+        ms.len[ms.nruns] = n;             // until the stack is
+        ms.nruns ++;                      // balanced
+        merge_collapse (&ms);
+    }
+
+    merge_force_collapse (&ms);
+
+    if (ms.owned)
+        BUF_FREE (ms.tmp);
+}
+
+void mergesort_natural (sorteddatatype A[],   // Array to be sorted
+                        uint32_t num)         // Size of the array
+{
+    mergesort_natural_buffer (A, num, NULL);
+}
+
+#undef MIN_GALLOP
+#undef MAX_RUNS
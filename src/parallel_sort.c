@@ -0,0 +1,324 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    parallel_sort.c
+
+    Implementation of a multithreaded sample sort. The array is
+    split in buckets of values, and then every bucket is sorted
+    with one of the sequential algorithms (the "kernel") in a
+    separate task:
+
+       1) SAMPLE: Take OVERSAMPLING samples per bucket from the
+          array and sort them. Every OVERSAMPLING-th sample is a
+          splitter. Repeated splitters are removed
+
+       2) COUNT: The array is divided in chunks. In parallel, the
+          elements of every chunk are classified with a binary
+          search among the splitters, and counted per bucket
+
+       3) SCATTER: The counts give the final position of every
+          bucket (and of the part of every chunk in it). In
+          parallel, every chunk copies its elements to their
+          buckets, in an auxiliary array of the same size
+
+       4) SORT: Every bucket is sorted with the kernel and copied
+          back to the original array. Larger buckets are
+          submitted (and so started) first, and the small ones
+          fill the gaps at the end
+
+    Every splitter has its own "equality bucket" for the values
+    equal to it. These buckets don't need to be sorted at all, so
+    a value repeated many times (skewed data) doesn't produce a
+    huge bucket that keeps a single thread busy. For other kinds
+    of imbalance, there are BUCKETS_PER_THREAD buckets per thread
+    and the tasks run in a work-stealing pool (see workpool.h).
+
+    This algorithm needs an auxiliary array of 'num' elements. If
+    it can't be allocated (or the array is small, or there is
+    only one thread), the kernel sorts the whole array in the
+    calling thread.
+
+    The kernel of parallel_sort() is quicksort(). Any other
+    function of this library with the same signature can be used
+    with parallel_sort_kernel()
+    ---------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sorting.h"
+#include "workpool.h"
+
+#define SERIAL_MAX          65536  // Sort smaller arrays serially
+#define BUCKETS_PER_THREAD      8
+#define OVERSAMPLING           32  // Samples per bucket
+#define MAX_SPLITTERS        1023
+#define CHUNKS_PER_THREAD       4
+
+typedef struct
+{
+    sorteddatatype * A;       // Array to be sorted
+    sorteddatatype * B;       // Auxiliary array
+    uint32_t         num;     // Size of both
+    sortfunction     kernel;
+
+    sorteddatatype * spl;     // Splitters (sorted, not repeated)
+    int              nspl;
+    int              nbuckets;    // 2*nspl+1 (see classify())
+
+    uint32_t         chunk;   // Size of the chunks (but the last)
+    int              nchunks;
+    uint32_t *       pos;     // nchunks x nbuckets counters, that
+                              // become positions after COUNT
+    uint32_t *       start;   // First position of every bucket
+}                             // (nbuckets+1 values)
+sortjob;
+
+typedef struct
+{
+    sortjob * job;
+    int       index;          // Chunk or bucket
+    uint32_t  size;           // Size of the bucket
+}
+sorttask;
+
+void parallel_sort (sorteddatatype A[], uint32_t num, int nthreads)
+{
+    parallel_sort_kernel (A, num, nthreads, quicksort);
+}
+
+static inline int classify (const sorteddatatype spl[], int nspl,
+                            sorteddatatype x)
+{
+    const sorteddatatype * base;
+    int n, half, k;
+                                  // Binary search for the first
+    base = spl;                   // splitter not less than x
+    n = nspl;                     // (branchless)
+
+    while (n > 1)
+    {
+        half = n >> 1;
+        base = base[half] < x ? base+half : base;
+        n -= half;
+    }
+
+    k = (int)(base - spl) + (*base < x);
+                                  // Even buckets: values between
+    return 2*k + (k < nspl &&     // two splitters. Odd buckets:
+                  !(x < spl[k])); // values equal to a splitter
+}
+
+static void count_chunk (void * arg)
+{
+    sorttask * t = (sorttask *) arg;
+    sortjob * job = t->job;
+    uint32_t * cnt, i, end;
+
+    cnt = job->pos + (size_t)t->index * job->nbuckets;
+    i = (uint32_t)t->index * job->chunk;
+    end = t->index+1 < job->nchunks ? i + job->chunk : job->num;
+
+    for (; i<end; i++)
+        cnt[classify (job->spl, job->nspl, job->A[i])] ++;
+}
+
+static void scatter_chunk (void * arg)
+{
+    sorttask * t = (sorttask *) arg;
+    sortjob * job = t->job;
+    uint32_t * pos, i, end;
+
+    pos = job->pos + (size_t)t->index * job->nbuckets;
+    i = (uint32_t)t->index * job->chunk;
+    end = t->index+1 < job->nchunks ? i + job->chunk : job->num;
+
+    for (; i<end; i++)
+        job->B[pos[classify (job->spl, job->nspl, job->A[i])]++] =
+            job->A[i];
+}
+
+static void sort_bucket (void * arg)
+{
+    sorttask * t = (sorttask *) arg;
+    sortjob * job = t->job;
+    uint32_t first, size;
+
+    first = job->start[t->index];
+    size = job->start[t->index+1] - first;
+
+    if (!(t->index & 1))                          // Equality
+        job->kernel (job->B + first, size);       // buckets are
+                                                  // already sorted
+    memcpy (job->A + first, job->B + first,
+            size * sizeof(sorteddatatype));
+}
+
+static int by_size (const void * a, const void * b)
+{
+    uint32_t x = ((const sorttask *)a)->size;
+    uint32_t y = ((const sorttask *)b)->size;
+
+    return x < y ? 1 : x > y ? -1 : 0;       // Larger first
+}
+
+static int choose_splitters (sortjob * job, int nthreads)
+{
+    uint64_t rnd;         // xorshift64* state
+    int nsamples, target, i, j;
+    sorteddatatype * sam;
+
+    target = nthreads * BUCKETS_PER_THREAD - 1;
+    if (target > MAX_SPLITTERS)
+        target = MAX_SPLITTERS;
+
+    nsamples = (target + 1) * OVERSAMPLING;
+
+    sam = malloc (nsamples * sizeof(sorteddatatype));
+    job->spl = malloc (target * sizeof(sorteddatatype));
+    if (!sam || !job->spl)
+    {
+        free (sam);
+        return 0;
+    }
+
+    rnd = 0x9E3779B97F4A7C15ULL;      // Fixed seed: the result is
+                                      // deterministic
+    for (i=0; i<nsamples; i++)
+    {
+        rnd ^= rnd >> 12;
+        rnd ^= rnd << 25;
+        rnd ^= rnd >> 27;
+        sam[i] = job->A[(rnd * 2685821657736338717ULL >> 32)
+                        % job->num];
+    }
+
+    quicksort (sam, nsamples);
+
+    for (i=0, j=0; i<target; i++)              // Take every
+    {                                          // OVERSAMPLING-th
+        job->spl[j] = sam[(i+1)*OVERSAMPLING]; // sample, but skip
+                                               // repeated values
+        if (j == 0 || job->spl[j-1] < job->spl[j])
+            j ++;
+    }
+
+    job->nspl = j;
+    job->nbuckets = 2*j + 1;
+
+    free (sam);
+    return 1;
+}
+
+void parallel_sort_kernel (sorteddatatype A[], uint32_t num,
+                           int nthreads, sortfunction kernel)
+{
+    sortjob job;
+    sorttask * tasks;
+    workpool * pool;
+    uint32_t sum, b;
+    int c, ntasks;
+
+    if (nthreads < 1)
+        nthreads = workpool_processors ();
+
+    if (nthreads < 2 || num < SERIAL_MAX)
+    {
+        kernel (A, num);
+        return;
+    }
+
+    memset (&job, 0, sizeof(job));
+    job.A = A;
+    job.num = num;
+    job.kernel = kernel;
+    job.nchunks = nthreads * CHUNKS_PER_THREAD;
+    job.chunk = num / job.nchunks;
+
+    pool = NULL;
+    tasks = NULL;
+
+    job.B = malloc ((size_t)num * sizeof(sorteddatatype));
+
+    if (!job.B || !choose_splitters (&job, nthreads))
+        goto serial;
+
+    job.pos = calloc ((size_t)job.nchunks * job.nbuckets,
+                      sizeof(uint32_t));
+    job.start = malloc ((job.nbuckets+1) * sizeof(uint32_t));
+    ntasks = job.nchunks > job.nbuckets ? job.nchunks
+                                        : job.nbuckets;
+    tasks = malloc (ntasks * sizeof(sorttask));
+
+    if (!job.pos || !job.start || !tasks)
+        goto serial;
+
+    pool = workpool_create (nthreads);
+    if (!pool)
+        goto serial;
+
+    // COUNT
+
+    for (c=0; c<job.nchunks; c++)
+    {
+        tasks[c].job = &job;
+        tasks[c].index = c;
+        workpool_submit (pool, count_chunk, tasks+c);
+    }
+    workpool_wait (pool);
+                                          // Turn the counts into
+    for (b=0, sum=0; b<(uint32_t)job.nbuckets; b++)     // positions
+    {                                     // (bucket by bucket and,
+        job.start[b] = sum;               // inside every bucket,
+                                          // chunk by chunk)
+        for (c=0; c<job.nchunks; c++)
+        {
+            uint32_t * p = job.pos + (size_t)c*job.nbuckets + b;
+            uint32_t cnt = *p;
+
+            *p = sum;
+            sum += cnt;
+        }
+    }
+    job.start[job.nbuckets] = sum;
+
+    // SCATTER
+
+    for (c=0; c<job.nchunks; c++)
+        workpool_submit (pool, scatter_chunk, tasks+c);
+    workpool_wait (pool);
+
+    // SORT
+
+    for (c=0; c<job.nbuckets; c++)
+    {
+        tasks[c].job = &job;
+        tasks[c].index = c;
+        tasks[c].size = job.start[c+1] - job.start[c];
+    }
+
+    qsort (tasks, job.nbuckets, sizeof(sorttask), by_size);
+
+    for (c=0; c<job.nbuckets; c++)
+        workpool_submit (pool, sort_bucket, tasks+c);
+    workpool_wait (pool);
+
+    workpool_destroy (pool);
+    free (tasks);
+    free (job.start);
+    free (job.pos);
+    free (job.spl);
+    free (job.B);
+    return;
+
+serial:                                  // Not enough memory (or
+    free (tasks);                        // threads) for the
+    free (job.start);                    // parallel version
+    free (job.pos);
+    free (job.spl);
+    free (job.B);
+    kernel (A, num);
+}
@@ -0,0 +1,167 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    poplarsort.c
+
+    Implementation of poplar sort (Coenraad Bron and Wim H.
+    Hesselink, 1991). Like smoothsort_pow2_1(), it keeps the array
+    as a sequence of perfectly balanced heaps ("poplars") of sizes
+    2^k-1, laid out in postorder: the root of every poplar is its
+    last element, right after its right child, and the left child
+    begins the poplar.
+
+    The difference is in how the roots are kept in order. In
+    smoothsort, the roots of the heaps are always sorted, and
+    every new root is moved to its place with interheap_sift()
+    (the "trinkle"). Poplar sort doesn't order the roots at all:
+
+       1) BUILD: Every new element becomes a poplar of size 1 or,
+          if the last two poplars have the same size, the root of
+          a new poplar made of them. Then it is pushed down inside
+          its own poplar, and that's all
+
+       2) SORT: For every position, from the end, the roots of all
+          the poplars are scanned to find the maximum. If it isn't
+          the last one, it is swapped with it and pushed down in
+          its poplar. Then the last poplar loses its root and
+          splits in its two children
+
+    The sizes follow the skew binary number system, so there are
+    at most log2(N)+1 poplars and the scan takes O(log N). The
+    sifts only touch one poplar, and the children of every node
+    are at fixed distances (root-1 and root-2^k), so the accesses
+    are simpler than those of smoothsort. The positions and sizes
+    of the poplars are kept in two small arrays, so it sorts in
+    place with O(1) extra memory.
+
+    The price is that it is no longer O(N) for sorted data: the
+    build is O(N), but the scans make the second phase O(N log N)
+    anyway (with sorted data the last root is always the maximum,
+    so there are no moves, only comparisons). Like the smoothsort
+    family, it can be instrumented (see sortstats.h)
+    ---------------------------------------------------------------
+*/
+
+#include "sorting.h"
+#include "sortstats.h"
+
+#define POPLARS_MAX  64   // More than log2(1<<32)+1 poplars
+
+static inline void sift_in (sorteddatatype * root, int order);
+
+void poplarsort (sorteddatatype A[],       // Array to be sorted
+                 uint32_t num)             // Size of the array
+{
+    uint32_t pos[POPLARS_MAX];  // Position of the root of every
+    int ord[POPLARS_MAX];       // poplar and its order (a poplar of
+    int n;                      // order k has 2^(k+1)-1 elements)
+    int j, m;                   // Number of poplars, loop index and
+    uint32_t i;                 // poplar with the greatest root
+    sorteddatatype max;         // Greatest root found
+
+    if (num < 2)
+        return;
+
+    // 1st: BUILD THE POPLARS
+
+    n = 0;
+
+    for (i=0; i<num; i++)
+    {
+        if (n >= 2 && ord[n-1] == ord[n-2])  // If the last two have
+        {                                    // the same size, make
+            n --;                            // them the children
+            ord[n-1] ++;                     // of the new element
+            pos[n-1] = i;
+            sift_in (A+i, ord[n-1]);
+        }
+        else                                 // Otherwise, it is a
+        {                                    // new poplar of size 1
+            ord[n] = 0;
+            pos[n] = i;
+            n ++;
+        }
+    }
+
+    // 2nd: SORT
+
+    for (i=num-1; i>0; i--)     // Here, pos[n-1] == i
+    {
+        m = n - 1;              // Find the greatest root, starting
+        max = A[i];             // with the last one
+        STAT_READ (1);
+
+        for (j=n-2; j>=0; j--)
+        {
+            STAT_READ (1);
+            STAT_CMP (1);
+
+            if (max < A[pos[j]])
+            {
+                max = A[pos[j]];
+                m = j;
+            }
+        }
+
+        if (m != n-1)                  // If it isn't in place, swap
+        {                              // it with the last root and
+            A[pos[m]] = A[i];          // push down the value that
+            A[i] = max;                // goes to its poplar
+            STAT_READ (1);
+            STAT_WRITE (2);
+            sift_in (A+pos[m], ord[m]);
+        }
+
+        if (ord[n-1] == 0)             // Remove A[i] from the last
+            n --;                      // poplar. If it had children,
+        else                           // they are new poplars (left
+        {                              // first)
+            ord[n-1] --;
+            pos[n-1] = i - (1UL << (ord[n-1]+1));
+            ord[n] = ord[n-1];
+            pos[n] = i - 1;
+            n ++;
+        }
+    }
+}
+
+static inline void sift_in (sorteddatatype * root, int order)
+{
+    sorteddatatype * left;          // Position of left child
+    sorteddatatype * next;          // Chosen child (greater root)
+    sorteddatatype tmp;             // Value to move down
+
+    if (order < 1)       // If we are in a leaf,
+        return;          // there's nothing to do
+
+    tmp = *root;         // Backup the initial value
+    STAT_READ (1);
+
+    do                        // While there are children...
+    {
+        next = root - 1;      // Choose temporarily the right ch.
+
+        left = root - (1UL<<order);  // Locate the left child,
+        STAT_READ (2);               // compare the roots and
+        STAT_CMP (2);                // choose the greater
+        if (*next < *left)
+            next = left;
+                                    // If both roots are less than
+        if (*next <= tmp)           // the initial root, we have
+            break;                  // reached its final position
+
+        *root = *next;              // Otherwise, push up the
+                                    // greater root and
+        root = next;                // proceed down to the
+        order --;                   // next level
+        STAT_WRITE (1);
+        STAT_LEVEL ();
+    }
+    while (order > 0);         // If we reach a leaf, stop
+
+    *root = tmp;         // Write the initial value in its
+    STAT_WRITE (1);      // final position
+    STAT_SIFT ();
+}
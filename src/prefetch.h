@@ -0,0 +1,31 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    prefetch.h
+
+    Software prefetch hint used by the cache-conscious versions
+    of the algorithms. PREFETCH(p) asks the processor to bring
+    the cache line of address p, without waiting for it. It is a
+    hint: it never faults, even for an address out of the array,
+    and it expands to nothing on compilers without the builtin.
+
+    CACHE_LINE is the assumed size of a cache line in bytes
+    -------------------------------------------------------------
+*/
+
+#ifndef _PREFETCH_MKR_H_
+#define _PREFETCH_MKR_H_
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(p)  __builtin_prefetch (p)
+#else
+#define PREFETCH(p)  ((void)0)
+#endif
+
+#endif // _PREFETCH_MKR_H_
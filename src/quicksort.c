@@ -0,0 +1,327 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    quicksort.c
+
+    Implementation of quick sort. There are two versions of it in
+    this file:
+
+       1) quicksort() is an "introsort" (introspective sort, as
+          proposed by David Musser). It is a quick sort with:
+
+            * A pivot chosen as the median of three elements (the
+              first, the middle and the last) or, for more than
+              NINTHER_MIN elements, as Tukey's "ninther" (the
+              median of three medians of three)
+
+            * Hoare's partition scheme. The scans stop at elements
+              equal to the pivot, so many equal values are split
+              evenly instead of producing O(N^2) time
+
+            * A sorting network (see sortnet.c) for partitions
+              of up to CUTOFF elements. It has no branches to
+              mispredict and runs in SIMD registers, so it can
+              take much larger partitions than an insertion sort
+
+            * A limit to the depth of the recursion. Beyond
+              2*log2(N) levels, the partition at hand is sorted
+              with heapsort() instead. This bounds the worst case
+              to O(N log N) time even with an adversarial input
+
+          Only the smaller partition is sorted recursively. The
+          larger one is handled in the same loop, so the stack
+          never holds more than O(log N) calls
+
+       2) quicksort_median_of_medians() chooses the pivot with
+          the "median of medians" algorithm by Blum, Floyd, Pratt,
+          Rivest and Tarjan. The pivot is guaranteed to have
+          between 30% and 70% of the elements on each side, so
+          this version is O(N log N) in the worst case by itself,
+          without falling back to any other algorithm. Since that
+          selection has a cost, this version is slower on average.
+          It uses a three-way partition (less, equal and greater
+          than the pivot), so that the guarantee holds also with
+          repeated values
+
+    There is also nth_element(), an "introselect": it partitions
+    like quicksort() but only goes on with the partition that
+    contains the k-th position, so it takes O(N) time on average.
+    Beyond 2*log2(N) levels it switches to the median of medians
+    selection, which is O(N) in the worst case
+    ---------------------------------------------------------------
+*/
+
+#include "sorting.h"
+
+#define CUTOFF      SORTNET_MAX   // Max. size sorted with a
+                                  // sorting network
+#define NINTHER_MIN 128   // Min. size using the ninther as pivot
+
+static void introsort (sorteddatatype A[], uint32_t num,
+                       int depth);
+
+static uint32_t partition (sorteddatatype A[], uint32_t num);
+
+static void select_mom (sorteddatatype A[], uint32_t num,
+                        uint32_t k);
+
+static sorteddatatype pivot_mom (sorteddatatype A[], uint32_t num);
+
+static void partition3 (sorteddatatype A[], uint32_t num,
+                        sorteddatatype pivot,
+                        uint32_t * lt, uint32_t * gt);
+
+static inline void insertion (sorteddatatype A[], uint32_t num);
+
+void quicksort (sorteddatatype A[],        // Array to be sorted
+                uint32_t num)              // Size of the array
+{
+    int depth;            // Max. depth before using heapsort
+    uint32_t n;
+
+    for (depth=0, n=num; n>1; n>>=1)   // 2*floor(log2(num))
+        depth += 2;
+
+    introsort (A, num, depth);
+}
+
+void nth_element (sorteddatatype A[],      // Array to be sorted
+                  uint32_t num,            // Size of the array
+                  uint32_t k)              // Position to place
+{
+    int depth;            // Max. depth before using select_mom()
+    uint32_t n, p;
+
+    if (k >= num)
+        return;
+
+    for (depth=0, n=num; n>1; n>>=1)
+        depth += 2;
+
+    while (num > CUTOFF)
+    {
+        if (depth-- == 0)              // If it gets too deep,
+        {                              // select in worst case
+            select_mom (A, num, k);    // O(N) time
+            return;
+        }
+
+        p = partition (A, num);
+
+        if (k < p)                     // Go on with the partition
+            num = p;                   // that contains A[k]
+        else if (k > p)
+        {
+            A += p + 1;
+            num -= p + 1;
+            k -= p + 1;
+        }
+        else
+            return;
+    }
+
+    sortnet (A, num);
+}
+
+void quicksort_median_of_medians (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num)             // Size of the array
+{
+    sorteddatatype pivot;
+    uint32_t lt, gt;      // Limits of the three partitions
+
+    while (num > CUTOFF)
+    {
+        pivot = pivot_mom (A, num);
+
+        partition3 (A, num, pivot, &lt, &gt);
+
+        if (lt < num-gt)                // Sort the smaller part
+        {                               // recursively and go on
+            quicksort_median_of_medians (A, lt);   // with the
+            A += gt;                               // larger one
+            num -= gt;
+        }
+        else
+        {
+            quicksort_median_of_medians (A+gt, num-gt);
+            num = lt;
+        }
+    }
+
+    sortnet (A, num);
+}
+
+static inline void swap (sorteddatatype * a, sorteddatatype * b)
+{
+    sorteddatatype tmp;
+
+    tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static inline uint32_t median3 (sorteddatatype A[],
+                                uint32_t a, uint32_t b, uint32_t c)
+{                                      // Position of the median
+    return A[a] < A[b] ?               // of A[a], A[b] and A[c]
+                ( A[b] < A[c] ? b : A[a] < A[c] ? c : a ) :
+                ( A[a] < A[c] ? a : A[b] < A[c] ? c : b );
+}
+
+static inline void insertion (sorteddatatype A[], uint32_t num)
+{
+    sorteddatatype tmp;   // Value to insert
+    uint32_t i, j;
+
+    for (i=1; i<num; i++)
+    {
+        tmp = A[i];                         // Move greater values
+                                            // one step to the
+        for (j=i; j && tmp < A[j-1]; j--)   // right with chained
+            A[j] = A[j-1];                  // swaps, and put the
+                                            // value in the hole
+        A[j] = tmp;
+    }
+}
+
+static uint32_t partition (sorteddatatype A[], uint32_t num)
+{
+    sorteddatatype pivot; // The pivot is in A[0] during the scan
+    uint32_t i, j;        // Left and right scan positions
+    uint32_t m, s;        // Middle position and sample step
+
+    m = num >> 1;
+
+    if (num < NINTHER_MIN)                       // Choose a pivot
+        m = median3 (A, 0, m, num-1);            // and move it
+    else                                         // to A[0]
+    {
+        s = num >> 3;
+        m = median3 (A, median3 (A, 0,     s,     2*s),
+                        median3 (A, m-s,   m,     m+s),
+                        median3 (A, num-1-2*s, num-1-s, num-1));
+    }
+
+    swap (A, A+m);
+    pivot = A[0];
+
+    i = 0;
+    j = num;
+
+    for (;;)
+    {
+        do                              // Scan from the left
+            i ++;                       // while the values are
+        while (i < j && A[i] < pivot);  // less than the pivot
+
+        do                              // Scan from the right
+            j --;                       // while the values are
+        while (pivot < A[j]);           // greater (A[0] stops
+                                        // this loop)
+        if (i >= j)
+            break;
+                                        // Both found values that
+        swap (A+i, A+j);                // are in the wrong side
+    }
+
+    swap (A, A+j);        // Put the pivot between both partitions
+    return j;             // and return its position
+}
+
+static void introsort (sorteddatatype A[], uint32_t num, int depth)
+{
+    uint32_t p;           // Final position of the pivot
+
+    while (num > CUTOFF)
+    {
+        if (depth-- == 0)          // If the recursion gets too
+        {                          // deep, the input is probably
+            heapsort (A, num);     // adversarial. Heap sort this
+            return;                // partition in O(N log N)
+        }
+
+        p = partition (A, num);
+
+        if (p < num-p)                      // Sort the smaller
+        {                                   // part recursively
+            introsort (A, p, depth);        // and go on with the
+            A += p + 1;                     // larger one
+            num -= p + 1;
+        }
+        else
+        {
+            introsort (A+p+1, num-p-1, depth);
+            num = p;
+        }
+    }
+
+    sortnet (A, num);
+}
+
+static void partition3 (sorteddatatype A[], uint32_t num,
+                        sorteddatatype pivot,
+                        uint32_t * lt, uint32_t * gt)
+{
+    uint32_t i, l, g;     // Dijkstra's "Dutch national flag":
+                          //
+    l = 0;                //   A[0..l)  <  pivot
+    i = 0;                //   A[l..i)  == pivot
+    g = num;              //   A[i..g)  not seen yet
+                          //   A[g..num) > pivot
+    while (i < g)
+    {
+        if (A[i] < pivot)
+            swap (A + l++, A + i++);
+        else if (pivot < A[i])
+            swap (A + i, A + --g);
+        else
+            i ++;
+    }
+
+    *lt = l;
+    *gt = g;
+}
+
+static void select_mom (sorteddatatype A[], uint32_t num, uint32_t k)
+{
+    sorteddatatype pivot;
+    uint32_t lt, gt;      // Limits of the three partitions
+
+    while (num > CUTOFF)           // Place the k-th smallest
+    {                              // value in A[k], with smaller
+        pivot = pivot_mom (A, num);    // ones at its left and
+                                       // greater ones at its
+        partition3 (A, num, pivot, &lt, &gt);      // right
+
+        if (k < lt)                // Go on with the partition
+            num = lt;              // that contains A[k]
+        else if (k >= gt)
+        {
+            A += gt;
+            num -= gt;
+            k -= gt;
+        }
+        else
+            return;
+    }
+
+    sortnet (A, num);
+}
+
+static sorteddatatype pivot_mom (sorteddatatype A[], uint32_t num)
+{
+    uint32_t i, g;        // Position of a group and group number
+
+    for (i=0, g=0; i+5<=num; i+=5, g++)  // For every group of 5
+    {
+        insertion (A+i, 5);        // Sort it and move its median
+        swap (A+g, A+i+2);         // to the beginning of A
+    }
+                                   // Find the median of the
+    select_mom (A, g, g>>1);       // medians, recursively
+                                   // (there are at least 3 groups,
+    return A[g>>1];                // since num > CUTOFF)
+}
@@ -0,0 +1,298 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    radixsort.c
+
+    Implementation of LSD (least significant digit first) radix
+    sort for doubles. It doesn't compare elements at all: it
+    distributes them by their digits of RADIX_BITS bits, from the
+    least significant to the most significant one, in a stable
+    way. It takes O(N) time for any input, with a constant that
+    beats the comparison sorts for large arrays.
+
+    The bits of a double are turned into an unsigned integer key
+    with the same order:
+
+        Positive values (sign 0): the sign bit is set
+
+        Negative values (sign 1): all bits are inverted, so that
+                                  the greater magnitudes go first
+
+    This gives a total order: -NaN < -inf < negative values < -0.0
+    < +0.0 < positive values < +inf < +NaN. The NaNs with the sign
+    bit set go to the beginning, and the rest go to the end.
+
+    The algorithm makes a first pass that transforms the keys in
+    place and counts the digits of every position at once. Then,
+    every digit position is distributed from the array to an
+    auxiliary one (or back). A position where all keys have the
+    same digit is skipped, since it wouldn't change anything. At
+    the end, the keys are turned back into doubles.
+
+    There are two entry points:
+
+       1) radixsort() allocates the auxiliary array (num
+          elements). If it needs more than RADIXSORT_MEMORY_CAP
+          bytes, or the allocation fails, the array is sorted
+          with heapsort() instead, in place (see below)
+
+       2) radixsort_buffer() takes the auxiliary array from the
+          caller, so it doesn't allocate anything but the small
+          tables of counters
+
+    Small arrays are sorted with quicksort(), because clearing
+    the counters would cost more than sorting them.
+
+    The comparison sorts only promise an order for arrays without
+    NaNs, and they don't tell -0.0 from +0.0. So, both fallbacks
+    go through sort_total(), that keeps the total order of the
+    keys: it moves the NaNs to both ends (by sign) and sorts each
+    group of NaNs with the same function, as the subnormals that
+    they become with the exponent bits cleared (in the same order
+    as their keys). Then it sorts the rest, and puts the -0.0
+    before the +0.0 in the block of zeros. All of this is O(N),
+    but the sorts themselves.
+
+    The digit size can be changed at compile time: 11 bits (6
+    passes with tables that fit in L1) is the default, and 16
+    bits (4 passes with larger tables) may be faster for huge
+    arrays
+    ---------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sorting.h"
+#include "sortstats.h"
+
+#ifndef RADIX_BITS
+#define RADIX_BITS  11
+#endif
+
+#ifndef RADIXSORT_MEMORY_CAP                 // Max. size of the
+#define RADIXSORT_MEMORY_CAP  ((size_t)1<<30)  // auxiliary array
+#endif                                       // (bytes)
+
+#define RADIX_MIN   1024       // Smaller arrays use quicksort()
+#define RADIX       (1 << RADIX_BITS)
+#define PASSES      ((64 + RADIX_BITS - 1) / RADIX_BITS)
+#define SIGN        0x8000000000000000ULL
+#define EXPONENT    0x7FF0000000000000ULL
+
+static inline uint64_t get_key (const sorteddatatype * p)
+{
+    uint64_t u;
+
+    memcpy (&u, p, sizeof(u));
+    return u;
+}
+
+static inline void put_key (sorteddatatype * p, uint64_t u)
+{
+    memcpy (p, &u, sizeof(u));
+}
+
+static inline uint64_t to_key (uint64_t u)   // Bits of a double to
+{                                            // key with same order
+    return u ^ ((0 - (u >> 63)) | SIGN);
+}
+
+static inline uint64_t from_key (uint64_t u) // Inverse of to_key()
+{
+    return u ^ (((u >> 63) - 1) | SIGN);
+}
+
+static inline int is_nan (uint64_t u)       // Bits of a NaN?
+{
+    return (u & ~SIGN) > EXPONENT;
+}
+
+static void sort_nans (sorteddatatype A[], uint32_t num,
+                       sortfunction sort)
+{
+    uint32_t i;              // Clear the exponent bits of the NaNs
+                             // (all of the same sign), sort them
+    for (i=0; i<num; i++)    // as subnormals and set them back
+        put_key (A+i, get_key (A+i) & ~EXPONENT);
+
+    sort (A, num);
+
+    for (i=0; i<num; i++)
+        put_key (A+i, get_key (A+i) | EXPONENT);
+    STAT_READ (2 * num);
+    STAT_WRITE (2 * num);
+}
+
+static void sort_total (sorteddatatype A[], uint32_t num,
+                        sortfunction sort)
+{
+    sorteddatatype tmp;
+    uint32_t lo, i, hi;      // -NaNs in A[0..lo), +NaNs in A[hi..num)
+    uint32_t z, negzeros;    // First zero, and number of -0.0
+    uint32_t m;
+    uint64_t u;
+
+    lo = i = 0;
+    hi = num;
+
+    while (i < hi)                     // Move the NaNs to both ends,
+    {                                  // by sign
+        u = get_key (A+i);
+
+        if (!is_nan (u))
+            i ++;
+        else
+        {
+            tmp = A[i];
+
+            if (u & SIGN)
+            {
+                A[i++] = A[lo];
+                A[lo++] = tmp;
+            }
+            else
+            {
+                A[i] = A[--hi];
+                A[hi] = tmp;
+            }
+            STAT_WRITE (2);
+        }
+    }
+    STAT_READ (num);
+
+    sort_nans (A, lo, sort);
+    sort_nans (A+hi, num-hi, sort);
+    sort (A+lo, hi-lo);
+
+    while (lo < hi)                    // The zeros are together
+    {                                  // now. Find the first one
+        m = lo + ((hi - lo) >> 1);     // (binary search), count
+        STAT_READ (1);                 // the -0.0 and put them
+        STAT_CMP (1);                  // first
+
+        if (A[m] < 0)
+            lo = m + 1;
+        else
+            hi = m;
+    }
+
+    z = lo;
+
+    for (i=z, negzeros=0; i<num && A[i] == 0; i++)
+        negzeros += (uint32_t)(get_key (A+i) >> 63);
+    STAT_READ (i - z);
+
+    for (i=z; i<z+negzeros; i++)
+        A[i] = -0.0;
+
+    for (; i<num && A[i] == 0; i++)
+        A[i] = 0.0;
+}
+
+static void radixsort_passes (sorteddatatype A[], uint32_t num,
+                              sorteddatatype B[], uint32_t * cnt);
+
+void radixsort (sorteddatatype A[],        // Array to be sorted
+                uint32_t num)              // Size of the array
+{
+    radixsort_buffer (A, num, NULL);
+}
+
+void radixsort_buffer (
+                sorteddatatype A[],        // Array to be sorted
+                uint32_t num,              // Size of the array
+                sorteddatatype B[])        // Auxiliary array of
+{                                          // 'num' elements (or
+    sorteddatatype * aux;                  // NULL to allocate it)
+    uint32_t * cnt;
+
+    if (num < RADIX_MIN)
+    {
+        sort_total (A, num, quicksort);
+        return;
+    }
+
+    aux = B;
+    if (!aux && (size_t)num * sizeof(sorteddatatype) <=
+                RADIXSORT_MEMORY_CAP)
+        aux = malloc ((size_t)num * sizeof(sorteddatatype));
+
+    cnt = calloc ((size_t)PASSES * RADIX, sizeof(uint32_t));
+
+    if (aux && cnt)
+        radixsort_passes (A, num, aux, cnt);
+    else                                  // Not enough memory:
+        sort_total (A, num, heapsort);    // sort in place
+
+    if (aux != B)
+        free (aux);
+    free (cnt);
+}
+
+static void radixsort_passes (sorteddatatype A[], uint32_t num,
+                              sorteddatatype B[], uint32_t * cnt)
+{
+    sorteddatatype * src, * dst, * tmp;
+    uint32_t * c;         // Counters of the current digit
+    uint32_t i, b, sum, n;
+    uint64_t k, first;
+    int d, shift;
+
+    // 1st: TRANSFORM AND COUNT
+
+    for (i=0; i<num; i++)
+    {
+        k = to_key (get_key (A+i));
+        put_key (A+i, k);
+
+        for (d=0; d<PASSES; d++)                 // (The compiler
+            cnt[d*RADIX +                        // unrolls this)
+                (int)((k >> (d*RADIX_BITS)) & (RADIX-1))] ++;
+    }
+    STAT_READ (num);
+    STAT_WRITE (num);
+
+    // 2nd: DISTRIBUTE
+
+    src = A;
+    dst = B;
+    first = get_key (A);
+
+    for (d=0; d<PASSES; d++)
+    {
+        shift = d * RADIX_BITS;
+        c = cnt + d*RADIX;
+                                             // Skip it if all keys
+        if (c[(first >> shift) & (RADIX-1)] == num)   // have the
+            continue;                                 // same digit
+
+        for (b=0, sum=0; b<RADIX; b++)       // Turn the counts into
+        {                                    // the first position
+            n = c[b];                        // for every digit
+            c[b] = sum;
+            sum += n;
+        }
+
+        for (i=0; i<num; i++)
+        {
+            k = get_key (src+i);
+            put_key (dst + c[(k >> shift) & (RADIX-1)]++, k);
+        }
+        STAT_READ (num);
+        STAT_WRITE (num);
+
+        tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    // 3rd: TRANSFORM BACK
+                                         // (and copy to A, if the
+    for (i=0; i<num; i++)                // last pass left the
+        put_key (A+i, from_key (get_key (src+i)));   // data in B)
+    STAT_READ (num);
+    STAT_WRITE (num);
+}
@@ -55,34 +55,106 @@
             
         - While moving values around, some assignments are saved
           with the trick of chained swaps
+
+    Since extract() takes the greatest remaining element in every
+    step, it can stop early: smoothsort_top() leaves only the k
+    greatest elements sorted at the end of the array (the rest
+    stays in the heaps, in no particular order). This takes
+    O(N + k log N) time, since heapify() is O(N)
+
+    The list of heaps is also available as a priority queue over
+    a buffer owned by the caller (see smoothheap in sorting.h):
+
+        - smoothheap_push() appends an element to the buffer, as
+          one step of heapify(), and always propagates it with
+          interheap_sift() (the queue may be popped at any moment,
+          so all the roots must be in order). With ascending
+          input, this is O(1) per element
+
+        - smoothheap_pop() is one step of extract(). The popped
+          maximum stays at the end of the buffer
+
+        - smoothheap_heapify() takes a whole array at once in
+          O(N). Then, every pop yields the next greatest element,
+          so this works as a lazy sorted iterator: stopping after
+          k elements costs only O(N + k log N), and the popped
+          elements are left sorted at the end of the array
+
+    A sorted array is already a valid list of heaps, with the
+    roots in order, and its shape depends only on its size: the
+    greatest Leonardo numbers that fit, from left to right. So
+    smoothsort_append(), for a sorted prefix plus an appended
+    tail, computes the list of the prefix in O(log N) (see
+    hs_sorted()) and runs heapify() only on the tail. Before
+    that, the prefix elements not greater than the min. of the
+    tail are left out, since they are in place already. For T
+    new elements and M elements left, it takes O(M + T log M),
+    which is nearly linear in T if the tail goes after most of
+    the prefix (e.g. new timestamps). If the tail has to be
+    spread over the prefix, extract() does most of the work
+    anyway, and it takes about as long as smoothsort(). Between
+    calls, the queue keeps the list of heaps of its buffer, so
+    it can be persisted too:
+
+        - smoothheap_sorted() takes a sorted array, with the
+          computed list of heaps, in O(log N)
+
+        - smoothheap_append() adds the elements written by the
+          caller after the last one in the queue, all at once
+          (as heapify() does, instead of one smoothheap_push()
+          per element)
+
+    The functions that don't depend on the sizes of the heaps are
+    in smoothsort_engine.h, shared with the other variants.
+    smoothsort_leonardo.h defines the family of sizes (the
+    Leonardo numbers) and the rules to update the list of heaps.
+    Both are shared with sorting.hpp too. The shifts of the mask
+    that skip the sizes not in use are done with a bit scan (see
+    bitops.h) instead of a loop.
+
+    Arrays of SMOOTHSORT_LARGE_MIN elements or more, that don't
+    fit in the caches, are sorted with the versions of the sifts
+    for large arrays (see ENGINE_PREFETCH in smoothsort_engine.h).
+    They prefetch the next level of both children of every heap
+    before choosing one. With random data, this is some 20% faster
+    with 10^7 elements, about the same with 10^6 and a bit slower
+    below 10^5 (hence the threshold). Sorted data are not affected
+    (heapsort_floyd() is still faster, though).
+
+    The sift functions can be instrumented (see sortstats.h).
+    Note that extract() doesn't touch the elements by itself; its
+    work is counted in the calls to interheap_sift()
     ---------------------------------------------------------------
 */
 
 #include "sorting.h"
+#include "smoothsort_leonardo.h"
 
-static const uint32_t L[] =     // Leonardo numbers in [0,1<<32)
-{
-    1UL, 1UL, 3UL, 5UL, 9UL, 15UL, 25UL, 41UL, 67UL, 109UL, 177UL,
-    287UL, 465UL, 753UL, 1219UL, 1973UL, 3193UL, 5167UL, 8361UL,
-    13529UL, 21891UL, 35421UL, 57313UL, 92735UL, 150049UL,
-    242785UL, 392835UL, 635621UL, 1028457UL, 1664079UL, 2692537UL,
-    4356617UL, 7049155UL, 11405773UL, 18454929UL, 29860703UL,
-    48315633UL, 78176337UL, 126491971UL, 204668309UL, 331160281UL,
-    535828591UL, 866988873UL, 1402817465UL, 2269806339UL,
-    3672623805UL
-};
-
-typedef struct
+static inline heapsizes hs_sorted (uint32_t num)
 {
-    uint64_t mask; // Leo. nums. in use (sizes of existing heaps)
-    int offset;    // Add this to every bit's position ('mask'
-}                  // always ends with a '1' bit, so 'offset' is
-heapsizes;         // also the size of the smallest heap)
+    heapsizes hsz;
+    uint64_t all;         // Bit k: there is a heap of size L[k]
+    int k;
+                                   // The list of heaps left by
+    all = 0;                       // heapify() for num elements
+                                   // (num>0) takes the greatest
+    for (k=LEONARDO_NUMS-1; k>=0; k--)  // Leonardo numbers that
+        if (L[k] <= num)                // fit, from left to right
+        {                               // (the last two may be L[1]
+            num -= L[k];                // and L[0])
+            all |= 1ULL << k;
+        }
+
+    hsz.offset = ctz64 (all);
+    hsz.mask = all >> hsz.offset;
+    return hsz;
+}
 
-static heapsizes heapify (sorteddatatype A[], uint32_t num);
+#include "smoothsort_engine.h"
 
-static void extract (sorteddatatype A[], uint32_t num,
-                     heapsizes hsz);
+#define ENGINE(x)  x##_large    // Versions for large arrays
+#define ENGINE_PREFETCH
+#include "smoothsort_engine.h"
 
 void smoothsort (sorteddatatype A[], uint32_t num)
 {
@@ -91,194 +163,248 @@ void smoothsort (sorteddatatype A[], uint32_t num)
     if (num < 2)  // If there's only one element, it's done.
         return;   // The other functions assume 2 or more elements
 
+    if (num >= SMOOTHSORT_LARGE_MIN)
+    {
+        hsz = heapify_large (A, num);
+        extract_large (A, num, hsz, 1);
+        return;
+    }
+
     hsz = heapify (A, num);   // Build the ordered list of heaps
 
-    extract (A, num, hsz);    // Consume the list of heaps
-}
+    extract (A, num, hsz, 1); // Consume the list of heaps. When
+}                             // only two remain (two heaps of
+                              // sizes L[1] and L[0]), it's done
+
+void smoothsort_top (sorteddatatype A[],   // Array to be sorted
+                     uint32_t num,         // Size of the array
+                     uint32_t k)           // Elements to sort
+{
+    heapsizes hsz;
 
-static inline void sift_in (sorteddatatype * root, int size);
+    if (num < 2 || k < 1)
+        return;
 
-static inline void interheap_sift (sorteddatatype * root,
-                                   heapsizes hsz);
+    if (num >= SMOOTHSORT_LARGE_MIN)
+    {
+        hsz = heapify_large (A, num);
+        extract_large (A, num, hsz, k < num-1 ? num-k : 1);
+        return;
+    }
 
-static heapsizes heapify (sorteddatatype A[], uint32_t num)
+    hsz = heapify (A, num);
+                                   // Stop when A[num-k] is the
+    extract (A, num, hsz,          // root of the last heap (the
+             k < num-1 ? num-k : 1);   // max. of the remaining
+}                                      // elements)
+
+void smoothsort_append (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t sorted_len,      // A[0..sorted_len) is sorted
+                 uint32_t num)             // Size of the array
 {
-    heapsizes hsz;       // 'List' of sizes of existing heaps
-    
-    uint32_t i;          // Loop index for traversing the array
-    
-    int wbf;             // Flag indicating whether a newly
-                         // created heap will be fused later in a
-                         // larger heap (wbf!=0) or not (wbf==0)
+    heapsizes hsz;
+    sorteddatatype min;   // Min. of the tail
+    uint32_t i, lo, hi, m;
+
+    if (sorted_len >= num)
+        return;
+
+    min = A[sorted_len];               // Find the min. of the tail,
+    STAT_READ (num - sorted_len);      // O(num-sorted_len)
 
-    hsz.mask = 1;             // Create a heap of size L[1]
-    hsz.offset = 1;           // containing the first element
+    for (i=sorted_len+1; i<num; i++)
+        if (A[i] < min)
+            min = A[i];
 
-    for (i=1; i<num; i++)     // With every following element...
+    STAT_CMP (num - sorted_len - 1);
+
+    lo = 0;                            // Elements of the prefix not
+    hi = sorted_len;                   // greater than it are in their
+                                       // final place already. Skip
+    while (lo < hi)                    // them, O(log sorted_len)
     {
-        if (hsz.mask & 2)          // If possible (if contiguous
-        {                                  // Leonardo numbers),
-            hsz.mask = (hsz.mask>>2) | 1;  // fuse last two heaps
-            hsz.offset += 2;
-        }                          // Otherwise,
-        else if (hsz.offset == 1)  // if last heap has size L[1]
-        {
-            hsz.mask = (hsz.mask << 1) | 1;  // the new is L[0]
-            hsz.offset = 0;
-        }
-        else                       // Otherwise, new heap L[1]
-        {
-            hsz.mask = (hsz.mask << (hsz.offset-1)) | 1;
-            hsz.offset = 1;
-        }
-        
-            // The current heap will be fused in the future if:
-            //
-            //     a) The sizes of this heap and the previous are
-            //        contiguous Leonardo numbers AND there is at
-            //        least one more element in the array
-            //  OR
-            //     b) This heap has size L[x] where x>0 AND there
-            //        is still space for a heap of size L[x-1] and
-            //        one more element (L[x]+L[x-1]+1 --> L[x+1])
-
-        wbf = ( (hsz.mask & 2) &&
-                i+1 < num                 ) ||
-              ( hsz.offset > 0    &&
-                1ULL+i+L[hsz.offset-1] < num );
-
-        if (wbf)                       // If this new heap will be
-            sift_in (A+i, hsz.offset); // fused, don't propagate
-        else                           // the root (just fix this
-            interheap_sift (A+i, hsz); // heap). If it will _not_
-    }                                  // be fused, propagate the
-                                       // root through the
-    return hsz;                        // sequence of heaps to
-}                                      // ensure correct ordering
-
-static void extract (sorteddatatype A[], uint32_t num,
-                     heapsizes hsz)
-{
-    uint32_t i;          // Loop index for traversing the array
+        m = lo + ((hi - lo) >> 1);
+        STAT_READ (1);
+        STAT_CMP (1);
 
-    uint32_t ch[2];      // Position of left and right children
-                         // of a newly created heap
-    int j;
-                             // Extract elems. starting at the end
-    for (i=num-1; i>1; i--)  // When only two remain, it's done
+        if (min < A[m])
+            hi = m;
+        else
+            lo = m + 1;
+    }
+
+    A += lo;
+    sorted_len -= lo;
+    num -= lo;
+
+    if (sorted_len < 1)
     {
-        if (hsz.offset<2)         // If last heap has size L[1] or
-        {                         // L[0] (both ==1), just remove
-            do                    // this heap (update the
-            {                     // heapsizes struct) leaving the
-                hsz.mask >>= 1;   // single element untouched
-                hsz.offset ++;
-            }                       // The mask will never be 0
-            while (!(hsz.mask&1));  // because the loop terminates
-        }                           // early (with two heaps of
-        else                        // sizes L[1] and L[0])
-        {
-            ch[1] = i - 1;                   // Position of right
-            ch[0] = ch[1] - L[hsz.offset-2]; // and left children
-
-            hsz.mask &= ~1ULL;       // Remove current heap
-
-            for (j=0; j<2; j++)      // For every child heap (left
-            {                                            // first)
-                hsz.mask = (hsz.mask << 1) | 1;
-                hsz.offset --;                  // Add heap to the
-                                                // list and ensure
-                interheap_sift (A+ch[j], hsz);  // ordering of
-            }                                   // roots
-        }
+        smoothsort (A, num);
+        return;
+    }
+                                         // A sorted prefix is a valid
+    hsz = hs_sorted (sorted_len);        // list of heaps, with the
+                                         // roots in order. Add only
+    if (num >= SMOOTHSORT_LARGE_MIN)     // the tail to it
+    {
+        hsz = heapify_from_large (A, sorted_len, num, hsz);
+        extract_large (A, num, hsz, 1);
+        return;
     }
+
+    hsz = heapify_from (A, sorted_len, num, hsz);
+    extract (A, num, hsz, 1);
 }
 
-static inline void sift_in (sorteddatatype * root, int size)
+void smoothheap_init (smoothheap * q,     // Queue to initialize
+                      sorteddatatype A[],  // Buffer (caller owned)
+                      uint32_t capacity)   // Size of the buffer
 {
-    sorteddatatype * left, * right; // Pos. of children heaps
-    sorteddatatype * next;          // Chosen child (greater root)
-    sorteddatatype tmp;             // Value to move down
-    int nsz;                        // Size of chosen child heap
-    
-    if (size < 2)        // If we are in a leaf,
-        return;          // there's nothing to do
+    q->A = A;
+    q->capacity = capacity;
+    q->num = 0;
+    q->mask = 0;          // No heaps
+    q->offset = 0;
+}
 
-    tmp = *root;         // Backup the initial value
-    
-    do                        // While there are children heaps...
+void smoothheap_heapify (
+                smoothheap * q,            // Queue to initialize
+                sorteddatatype A[],        // Elements (and buffer)
+                uint32_t num)              // Number of elements
+{
+    heapsizes hsz;
+
+    smoothheap_init (q, A, num);
+
+    if (num < 1)
+        return;
+
+    hsz = heapify (A, num);   // (heapify() leaves all the roots
+                              // in order when it finishes)
+    q->num = num;
+    q->mask = hsz.mask;
+    q->offset = hsz.offset;
+}
+
+int smoothheap_sorted (
+                smoothheap * q,            // Queue to initialize
+                sorteddatatype A[],        // Buffer (caller owned)
+                uint32_t capacity,         // Size of the buffer
+                uint32_t num)              // A[0..num) is sorted
+{                                          // (returns 0 if > capacity)
+    heapsizes hsz;
+
+    smoothheap_init (q, A, capacity);
+
+    if (num > capacity)
+        return 0;
+
+    if (num < 1)
+        return 1;
+
+    hsz = hs_sorted (num);    // Nothing to move: O(log num)
+
+    q->num = num;
+    q->mask = hsz.mask;
+    q->offset = hsz.offset;
+    return 1;
+}
+
+int smoothheap_append (smoothheap * q,     // Queue
+                       uint32_t num)       // Elements in q->A
+{                                          // (returns 0 if > capacity)
+    heapsizes hsz;
+
+    if (num > q->capacity)
+        return 0;
+
+    if (num <= q->num)
+        return 1;
+
+    if (q->num == 0)                       // Same steps as in
+        hsz = heapify (q->A, num);         // smoothheap_heapify()
+    else
     {
-        right = root - 1;           // Locate children
-        left = right - L[size-2];
-        
-        if (*right < *left)         // Compare their roots
-        {
-            next = left;            // Choose left child heap
-            nsz = size - 1;         // (larger subheap)
-        }
-        else
-        {
-            next = right;           // Choose right child heap
-            nsz = size - 2;         // (smaller subheap)
-        }
-                                    // If both roots are less than
-        if (*next <= tmp)           // the initial root, we have
-            break;                  // reached its final position
-
-        *root = *next;              // Otherwise, push up the
-                                    // greater root and
-        root = next;                // proceed down to the
-        size = nsz;                 // next level
+        hsz.mask = q->mask;
+        hsz.offset = q->offset;
+        hsz = heapify_from (q->A, q->num, num, hsz);
     }
-    while (size > 1);          // If we reach a leaf, stop
-    
-    *root = tmp;         // Write the initial value in its
-}                        // final position
 
-static inline void interheap_sift (sorteddatatype * root,
-                                   heapsizes hsz)
-{
-    sorteddatatype * next;   // Pos. of (root of) next heap
-    sorteddatatype * left;   // Pos. of left child of current heap
-    sorteddatatype * right;  //  "   "  right  "   "     "     "
-    sorteddatatype tmp;      // Value to move left
-    sorteddatatype max;      // Effective root value of curr. heap
-    
-    tmp = *root;      // Backup the initial value
-    
-    while (hsz.mask != 1)  // Traverse the list of heaps
-    {                      // from right to left
-        max = tmp;
-        
-        if (hsz.offset > 1)           // If this heap has children
-        {
-            right = root - 1;                 // Locate children
-            left = right - L[hsz.offset-2];
-            
-            if (max < *left)                  // Use the maximum
-                max = *left;                  // value for the
-                                              // comparison below,
-            if (max < *right)                 // since it is the
-                max = *right;                 // effective root
-        }                                     // of this heap
-        
-        next = root - L[hsz.offset];  // Position of next heap
-
-        if (*next <= max)             // If the ordeing is OK,
-            break;                    // stop here
-
-        *root = *next;                // Otherwise, push up the
-        root = next;                  // root of that heap and
-                                      // go there
-        do
-        {                             // Extract the previous
-            hsz.mask >>= 1;           // heap from the list (note
-            hsz.offset ++;            // that 'hsz' is just a
-        }                             // temporary copy)
-        while (!(hsz.mask&1));
+    q->num = num;
+    q->mask = hsz.mask;
+    q->offset = hsz.offset;
+    return 1;
+}
+
+int smoothheap_push (smoothheap * q,       // Queue
+                     sorteddatatype x)     // Element to insert
+{                                          // (returns 0 if full)
+    heapsizes hsz;
+
+    if (q->num >= q->capacity)
+        return 0;
+
+    hsz.mask = q->mask;
+    hsz.offset = q->offset;
+
+    if (q->num == 0)                       // Same steps as in
+        hsz = hs_first ();                 // heapify()
+    else
+        hs_grow (&hsz);
+
+    q->A[q->num] = x;
+    STAT_WRITE (1);
+    interheap_sift (q->A + q->num, hsz);
+
+    q->num ++;
+    q->mask = hsz.mask;
+    q->offset = hsz.offset;
+    return 1;
+}
+
+int smoothheap_peek (const smoothheap * q, // Queue
+                     sorteddatatype * x)   // Max. element (output)
+{                                          // (returns 0 if empty)
+    if (q->num < 1)
+        return 0;
+
+    *x = q->A[q->num-1];  // The root of the last heap is the max.
+    STAT_READ (1);
+    return 1;
+}
+
+int smoothheap_pop (smoothheap * q,        // Queue
+                    sorteddatatype * x)    // Max. element (output)
+{                                          // (returns 0 if empty)
+    heapsizes hsz, st[2];
+    uint32_t i;
+    uint32_t ch[2];
+    int j;
+
+    if (q->num < 1)
+        return 0;
+
+    i = q->num - 1;
+    *x = q->A[i];
+    STAT_READ (1);
+
+    hsz.mask = q->mask;
+    hsz.offset = q->offset;
+
+    if (i == 0)                   // Last element: no heaps left
+    {
+        hsz.mask = 0;
+        hsz.offset = 0;
     }
-                                      // Put the initial root in
-    *root = tmp;                      // the heap where we stopped
-    sift_in (root, hsz.offset);       // and ensure the correct
-}                                     // internal ordering in it
+    else if (LEAF(hsz.offset))    // Same steps as in extract()
+        hs_drop (&hsz);
+    else
+        for (j=hs_split (&hsz, i, ch, st); j<2; j++)
+            interheap_sift (q->A + ch[j], st[j]);
 
+    q->num = i;
+    q->mask = hsz.mask;
+    q->offset = hsz.offset;
+    return 1;
+}
@@ -0,0 +1,58 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    smoothsort_64.c
+
+    Version of smoothsort() for arrays of more than 4G elements.
+    The algorithm is the same as in smoothsort.c (see the comments
+    there), and so is the code: smoothsort_engine.h and
+    smoothsort_leonardo.h, included with KERNEL_64 defined (see
+    sortkernel.h). The differences are:
+
+        - The size of the array and the positions in it are size_t
+          values instead of uint32_t
+
+        - The table of Leonardo numbers is extended up to 1<<64
+
+        - A single uint64_t is not enough for the mask of heap
+          sizes. Above 4G elements there can be heaps of order up
+          to 91 and, at the same time, heaps of order 0 or 1. So,
+          the mask is made of two uint64_t (128 bits). See
+          smoothsort_mask.h
+
+    Large arrays are sorted with the prefetching sifts, as in
+    smoothsort.c. Note that smoothsort.c is still preferable for
+    smaller arrays, since it handles a simpler mask
+    ---------------------------------------------------------------
+*/
+
+#define KERNEL_64
+
+#include "sorting.h"
+#include "smoothsort_leonardo.h"
+#include "smoothsort_engine.h"
+
+#define ENGINE(x)  x##_large    // Versions for large arrays
+#define ENGINE_PREFETCH
+#include "smoothsort_engine.h"
+
+void smoothsort_64 (sorteddatatype A[], size_t num)
+{
+    heapsizes hsz;
+
+    if (num < 2)  // If there's only one element, it's done.
+        return;   // The other functions assume 2 or more elements
+
+    if (num >= SMOOTHSORT_LARGE_MIN)
+    {
+        hsz = heapify_large (A, num);
+        extract_large (A, num, hsz, 1);
+        return;
+    }
+
+    hsz = heapify (A, num);   // Build the ordered list of heaps
+
+    extract (A, num, hsz, 1); // Consume the list of heaps. When
+}                             // only two remain, it's done
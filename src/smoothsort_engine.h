@@ -0,0 +1,287 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    smoothsort_engine.h
+
+    The parts of smoothsort that don't depend on the sizes of
+    the heaps: sift_in(), interheap_sift(), heapify() and
+    extract(). heapify_from() is heapify() resumed at A[first],
+    with the list of heaps of A[0..first) (which must have its
+    roots in order, as heapify() leaves it).
+
+    This is not a regular header: every variant of smoothsort
+    (smoothsort.c, smoothsort_fib_1.c, smoothsort_pow2_1.c and
+    their _64 versions) includes it, after defining its family
+    of heap sizes (smoothsort_leonardo.h, smoothsort_fib_1.h and
+    smoothsort_pow2_1.h) with these macros:
+
+        HEAPSIZE(k)    Number of elements of a heap of order k
+        LEAF(k)        A heap of order k has no children
+        ONLY_CHILD(k)  A heap of order k has just one child
+        RIGHT(k)       Order of the right child (the one that
+                       precedes the root). If there is only one
+                       child, this is ignored
+        LEFT(k)        Order of the left child (or only child)
+
+    the type 'heapsizes' (the list of heaps, with a field
+    'offset' that is the order of the last one) and these
+    functions:
+
+        hs_first ()         List with one heap of one element
+        hs_grow (h)         Add one element to the list (fusing
+                            the last heaps or appending a new one)
+        hs_fused (h,i,num)  The last heap, whose root is A[i],
+                            will be fused in a larger one later
+        hs_single (h)       There is only one heap in the list
+        hs_drop (h)         Remove the last heap from the list
+        hs_split (h,i,ch,st)  Replace the last heap, whose root
+                            is A[i], with its children. Put their
+                            positions in ch[] and the lists that
+                            end in each of them in st[]. Return
+                            the index of the first child (0, or 1
+                            if there is only one)
+
+    The positions are of type 'sortindex' (see sortkernel.h), so
+    the _64 versions, with KERNEL_64 defined, get size_t positions
+    from the same code, and the families larger tables and masks.
+    smoothsort_payload.c gets the moves of the payloads with
+    KERNEL_PAYLOAD (all the functions take 'pay' at the end then).
+
+    In every variant, the children of a root precede it: first
+    the left child heap and then the right one. The code is the
+    one described in smoothsort.c. The comparisons and moves are
+    instrumented (see sortstats.h), and written with the macros
+    of sortkernel.h, so sorting.hpp includes the engine too, for
+    any element type and comparison. interheap_sift() keeps a
+    pointer to the effective root of every heap, instead of a
+    copy of its value
+
+    Optionally, the includer may define:
+
+        ENGINE(x)        Name of the function x (by default, x), to
+                         include the engine more than once
+        ENGINE_PREFETCH  Prefetch the next levels in sift_in(),
+                         for large arrays (see below)
+
+    With large arrays, the sifts wait for memory most of the
+    time: the two children of a heap are far apart, and the one
+    chosen by every comparison (a coin toss with random data)
+    tells where the next level is. With ENGINE_PREFETCH, sift_in()
+    prefetches (see prefetch.h) the left children of both children
+    before comparing them (their right children are next to
+    them), so the next level is on its way whatever the choice.
+    It does the same comparisons and moves, so it keeps all the
+    properties of the algorithm.
+
+    Choosing the child without branches (with arithmetic, like
+    heapsort_branchless()) was slower: the processor can't run
+    ahead into the next level until the comparison is done. So is
+    prefetching the next heaps in interheap_sift(): the list of
+    heaps is short and the loop usually stops at the first one
+    -------------------------------------------------------------
+*/
+
+#include "sortkernel.h"
+#include "sortstats.h"
+
+#ifndef ENGINE
+#define ENGINE(x)  x
+#endif
+
+#ifdef ENGINE_PREFETCH
+
+#include "prefetch.h"
+
+#define PREFETCH_LEFT(root,size)                             \
+    do                                  /* Bring the root of */  \
+    {                                   /* the left child of */  \
+        if (!LEAF(size) && !ONLY_CHILD(size))  /* a heap (the */ \
+            PREFETCH ((root) - 1 - HEAPSIZE(RIGHT(size)));       \
+    }                                   /* right one is next */  \
+    while (0)                           /* to its root)      */
+
+#else
+
+#define PREFETCH_LEFT(root,size)  ((void)0)
+
+#endif // ENGINE_PREFETCH
+
+KERNEL_STATIC inline void ENGINE(sift_in) (sorteddatatype * root,
+                                           int size PAYLOAD_PARAMS)
+{
+    sorteddatatype * left;          // Position of left child heap
+    sorteddatatype * next;          // Chosen child (greater root)
+    int nsz;                        // Size of chosen child heap
+
+    if (LEAF(size))      // If we are in a leaf,
+        return;          // there's nothing to do
+
+    sorteddatatype tmp = MOVE (*root);  // Backup the initial value
+    PAYLOAD_SAVE (root);
+    STAT_READ (1);
+
+    do                        // While there are children heaps...
+    {
+        next = root - 1;              // Choose temporarily the
+        STAT_READ (1);                // right (or only) child
+        nsz = ONLY_CHILD(size) ? LEFT(size) : RIGHT(size);
+
+        if (!ONLY_CHILD(size))
+        {
+            left = next - HEAPSIZE(RIGHT(size));   // Compare its
+            PREFETCH_LEFT (left, LEFT(size));      // root with the
+            PREFETCH_LEFT (next, RIGHT(size));     // one of the
+            STAT_READ (1);                         // left child
+            STAT_CMP (1);                          // (and bring the
+                                                   // next level of
+                                                   // both, if enabled)
+
+            if (LESS (*next, *left))
+            {
+                next = left;        // Choose left child heap
+                nsz = LEFT(size);   // (larger subheap)
+            }
+        }
+                                    // If both roots are less than
+        STAT_CMP (1);               // the initial root, we have
+        if (LESS_EQ (*next, tmp))   // reached its final position
+            break;
+
+        *root = MOVE (*next);       // Otherwise, push up the
+        PAYLOAD_MOVE (root, next);  // greater root and
+        root = next;                // proceed down to the
+        size = nsz;                 // next level
+        STAT_WRITE (1);
+        STAT_LEVEL ();
+    }
+    while (!LEAF(size));       // If we reach a leaf, stop
+
+    *root = MOVE (tmp);  // Write the initial value in its
+    PAYLOAD_LOAD (root); // final position
+    STAT_WRITE (1);
+    STAT_SIFT ();
+}
+
+KERNEL_STATIC KERNEL_INLINE void ENGINE(interheap_sift) (
+                                        sorteddatatype * root,
+                                        heapsizes hsz PAYLOAD_PARAMS)
+{
+    sorteddatatype tmp = MOVE (*root);  // Value to move left
+    sorteddatatype * next;   // Pos. of (root of) next heap
+    sorteddatatype * left;   // Pos. of left child of current heap
+    sorteddatatype * right;  //  "   "  right  "   "     "     "
+    sorteddatatype * max;    // Effective root value of curr. heap
+
+    PAYLOAD_SAVE (root);
+    STAT_READ (1);
+
+    while (!hs_single (hsz))  // Traverse the list of heaps
+    {                         // from right to left
+        max = &tmp;
+
+        if (!LEAF(hsz.offset))        // If this heap has children
+        {
+            right = root - 1;         // Locate them and use the
+            STAT_READ (1);            // maximum value for the
+            STAT_CMP (1);             // comparison below, since
+                                      // it is the effective root
+            if (LESS (*max, *right))  // of this heap
+                max = right;
+
+            if (!ONLY_CHILD(hsz.offset))
+            {
+                left = right - HEAPSIZE(RIGHT(hsz.offset));
+                STAT_READ (1);
+                STAT_CMP (1);
+
+                if (LESS (*max, *left))
+                    max = left;
+            }
+        }
+
+        next = root - HEAPSIZE(hsz.offset);    // Pos. of next heap
+        STAT_READ (1);
+        STAT_CMP (1);
+
+        if (LESS_EQ (*next, *max))    // If the ordering is OK,
+            break;                    // stop here
+
+        *root = MOVE (*next);         // Otherwise, push up the
+        PAYLOAD_MOVE (root, next);
+        root = next;                  // root of that heap and
+        STAT_WRITE (1);               // go there
+        STAT_LEVEL ();
+
+        hs_drop (&hsz);               // Extract the previous heap
+    }                                 // from the list (note that
+                                      // 'hsz' is a temporary copy)
+                                      // Put the initial root in
+    *root = MOVE (tmp);               // the heap where we stopped
+    PAYLOAD_LOAD (root);
+    STAT_WRITE (1);
+    STAT_SIFT ();
+    ENGINE(sift_in) (root, hsz.offset    // and ensure the correct
+                     PAYLOAD_ARGS);      // internal ordering in it
+}
+
+KERNEL_STATIC heapsizes ENGINE(heapify_from) (
+                                sorteddatatype A[],
+                                sortindex first, sortindex num,
+                                heapsizes hsz PAYLOAD_PARAMS)
+{
+    sortindex i;         // Loop index for traversing the array
+
+    for (i=first; i<num; i++) // With every following element...
+    {
+        hs_grow (&hsz);
+
+        if (hs_fused (hsz, i, num))             // If this new heap
+            ENGINE(sift_in) (A+i, hsz.offset    // will be fused,
+                             PAYLOAD_ARGS);     // don't propagate
+        else                                    // the root (just fix
+            ENGINE(interheap_sift) (A+i, hsz    // this heap).
+                                    PAYLOAD_ARGS);
+    }
+                                       // Otherwise, propagate the
+    return hsz;                        // root through the sequence
+}                                      // of heaps to ensure correct
+                                       // ordering
+
+KERNEL_STATIC heapsizes ENGINE(heapify) (sorteddatatype A[],
+                                         sortindex num PAYLOAD_PARAMS)
+{                                      // Create a heap containing
+    return ENGINE(heapify_from) (A, 1, num,      // the first element
+                                 hs_first ()     // and add the rest
+                                 PAYLOAD_ARGS);
+}
+
+KERNEL_STATIC void ENGINE(extract) (sorteddatatype A[], sortindex num,
+                                    heapsizes hsz, sortindex last
+                                    PAYLOAD_PARAMS)
+{
+    heapsizes st[2];     // Lists ending in every new heap
+    sortindex ch[2];     // Position of left and right children
+    sortindex i;         // of a newly created heap
+    int j;
+                                   // Extract elems. starting at
+    for (i=num-1; i>last; i--)     // the end, until A[last] is
+    {                              // the root of the last heap
+        if (LEAF(hsz.offset))      // If the last heap is a leaf,
+            hs_drop (&hsz);        // just remove it from the list
+        else                       // leaving the element untouched
+        {
+            j = hs_split (&hsz, i, ch, st);
+
+            for (; j<2; j++)                     // For every child
+                ENGINE(interheap_sift) (         // heap (left first),
+                        A+ch[j], st[j]           // ensure the ordering
+                        PAYLOAD_ARGS);           // of the roots
+        }
+    }
+}
+
+#undef ENGINE
+#undef ENGINE_PREFETCH
+#undef PREFETCH_LEFT
@@ -0,0 +1,159 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    smoothsort_fib_1.h
+
+    The family of heap sizes of smoothsort_fib_1.c (the nonzero
+    Fibonacci-minus-1 numbers) and the rules to update the list
+    of heaps, as required by smoothsort_engine.h. Included by
+    smoothsort_fib_1.c, smoothsort_fib_1_64.c (with KERNEL_64,
+    for a larger table and mask, see sortkernel.h) and
+    sorting.hpp
+    -------------------------------------------------------------
+*/
+
+#include "sortkernel.h"
+                                 // Nonzero Fibonacci-1 numbers
+#ifdef KERNEL_64
+#define MASK_BITS  128
+static const uint64_t E[] =      // in the range [1,1<<64)
+#else
+#define MASK_BITS  64
+static const uint32_t E[] =      // in the range [1,1<<32)
+#endif
+{
+    1UL, 2UL, 4UL, 7UL, 12UL, 20UL, 33UL, 54UL, 88UL, 143UL,
+    232UL, 376UL, 609UL, 986UL, 1596UL, 2583UL, 4180UL, 6764UL,
+    10945UL, 17710UL, 28656UL, 46367UL, 75024UL, 121392UL,
+    196417UL, 317810UL, 514228UL, 832039UL, 1346268UL, 2178308UL,
+    3524577UL, 5702886UL, 9227464UL, 14930351UL, 24157816UL,
+    39088168UL, 63245985UL, 102334154UL, 165580140UL, 267914295UL,
+    433494436UL, 701408732UL, 1134903169UL, 1836311902UL,
+    2971215072UL
+#ifdef KERNEL_64
+  , 4807526975ULL, 7778742048ULL,
+    12586269024ULL, 20365011073ULL, 32951280098ULL, 53316291172ULL,
+    86267571271ULL, 139583862444ULL, 225851433716ULL, 365435296161ULL,
+    591286729878ULL, 956722026040ULL, 1548008755919ULL,
+    2504730781960ULL, 4052739537880ULL, 6557470319841ULL,
+    10610209857722ULL, 17167680177564ULL, 27777890035287ULL,
+    44945570212852ULL, 72723460248140ULL, 117669030460993ULL,
+    190392490709134ULL, 308061521170128ULL, 498454011879263ULL,
+    806515533049392ULL, 1304969544928656ULL, 2111485077978049ULL,
+    3416454622906706ULL, 5527939700884756ULL, 8944394323791463ULL,
+    14472334024676220ULL, 23416728348467684ULL, 37889062373143905ULL,
+    61305790721611590ULL, 99194853094755496ULL, 160500643816367087ULL,
+    259695496911122584ULL, 420196140727489672ULL,
+    679891637638612257ULL, 1100087778366101930ULL,
+    1779979416004714188ULL, 2880067194370816119ULL,
+    4660046610375530308ULL, 7540113804746346428ULL,
+    12200160415121876737ULL
+#endif
+};
+
+#include "smoothsort_mask.h"
+
+typedef struct
+{
+    hsmask mask;   // Fib-1 nums. in use (sizes of existing heaps)
+    int offset;    // Add this to every bit's position ('mask'
+}                  // always ends with a '1' bit, so 'offset' is
+heapsizes;         // also the size of the smallest heap)
+
+#define HEAPSIZE(k)    E[k]           // A heap of order k>1 has
+#define LEAF(k)        ((k) < 1)      // children of orders k-1
+#define ONLY_CHILD(k)  ((k) == 1)     // (left) and k-2 (right).
+#define LEFT(k)        ((k) - 1)      // Order 1 has only a child
+#define RIGHT(k)       ((k) - 2)      // of order 0
+
+static inline heapsizes hs_first (void)
+{
+    heapsizes hsz;
+
+    hsz.mask = mask_one ();   // A heap of size E[0]
+    hsz.offset = 0;
+    return hsz;
+}
+
+static inline void hs_grow (heapsizes * hsz)
+{
+    if (MASK_LOW (hsz->mask) & 2)      // If possible (if
+    {                                  // contiguous Fib.-1
+        hsz->mask = mask_shr (hsz->mask, 2);   // numbers), fuse
+        MASK_LOW (hsz->mask) |= 1;             // the last two
+        hsz->offset += 2;                      // heaps
+    }                              // Otherwise,
+    else if (hsz->offset == 0)     // if last heap has size E[0]
+    {
+        hsz->mask = mask_shr (hsz->mask, 1);   // Make it of size
+        MASK_LOW (hsz->mask) |= 1;             // E[1]
+        hsz->offset = 1;
+    }
+    else       // Otherwise, just append a heap of size E[0]
+    {
+        hsz->mask = mask_shl (hsz->mask, hsz->offset);
+        MASK_LOW (hsz->mask) |= 1;
+        hsz->offset = 0;
+    }
+}
+
+static inline int hs_fused (heapsizes hsz, sortindex i, sortindex num)
+{
+        // The current heap will be fused in the future if:
+        //
+        //     a) The sizes of this heap and the previous are
+        //        contiguous Fib-1 numbers AND there is at
+        //        least one more element in the array
+        //  OR
+        //     b) This heap has size E[x] where x>0 AND there
+        //        is still space for a heap of size E[x-1] and
+        //        one more element (E[x]+E[x-1]+1 --> E[x+1])
+        //
+        // (i+1+E[x-1] < num, written so that it can't overflow)
+
+    return ( (MASK_LOW (hsz.mask) & 2) &&
+             i+1 < num                 ) ||
+           ( hsz.offset > 0    &&
+             E[hsz.offset-1] < num-i-1 );
+}
+
+static inline int hs_single (heapsizes hsz)
+{
+    return mask_single (hsz.mask);
+}
+
+static inline void hs_drop (heapsizes * hsz)
+{
+    int z;                         // Remove the last heap and skip
+                                   // the sizes not in use (the
+    MASK_LOW (hsz->mask) &= ~1ULL;  // mask will never be 0 here)
+    z = mask_skip (&hsz->mask);
+    hsz->offset += z;
+}
+
+static inline int hs_split (heapsizes * hsz, sortindex i,
+                            sortindex ch[2], heapsizes st[2])
+{
+    int j, first;
+
+    ch[first=1] = i - 1;              // Position of right
+                                      // and left child
+    if (hsz->offset > 1)                    // (if any)
+        ch[first=0] = ch[1] - E[hsz->offset-2];
+
+    MASK_LOW (hsz->mask) &= ~1ULL;    // Remove current heap
+
+    for (j=first; j<2; j++)           // Add the children to the
+    {                                 // list (left first)
+        hsz->mask = mask_shl (hsz->mask, 1);
+        MASK_LOW (hsz->mask) |= 1;
+        hsz->offset --;
+        st[j] = *hsz;
+    }
+
+    return first;
+}
+
+#undef MASK_LOW
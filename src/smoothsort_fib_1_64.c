@@ -0,0 +1,35 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    smoothsort_fib_1_64.c
+
+    Version of smoothsort_fib_1() for arrays of more than 4G
+    elements. The algorithm is the same as in smoothsort_fib_1.c
+    (see the comments there). As in smoothsort_64.c, the code is
+    shared (smoothsort_engine.h and smoothsort_fib_1.h, with
+    KERNEL_64 defined): the positions are size_t values, the table
+    of sizes is extended up to 1<<64 and the mask of heap sizes
+    has 128 bits
+    ---------------------------------------------------------------
+*/
+
+#define KERNEL_64
+
+#include "sorting.h"
+#include "smoothsort_fib_1.h"
+#include "smoothsort_engine.h"
+
+void smoothsort_fib_1_64 (sorteddatatype A[], size_t num)
+{
+    heapsizes hsz;
+
+    if (num < 2)  // If there's only one element, it's done.
+        return;   // The other functions assume 2 or more elements
+
+    hsz = heapify (A, num);   // Build the ordered list of heaps
+
+    extract (A, num, hsz, 2); // Consume the list of heaps. When
+}                             // only three remain (heaps of sizes
+                              // E[1] and E[0]), it's done
@@ -0,0 +1,163 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    smoothsort_leonardo.h
+
+    The family of heap sizes of smoothsort.c (the Leonardo
+    numbers) and the rules to update the list of heaps, as
+    required by smoothsort_engine.h. smoothsort.c includes it,
+    smoothsort_64.c too (with KERNEL_64, for a larger table and
+    mask, see sortkernel.h) and sorting.hpp (inside a namespace
+    of its own, so that the three families can be used in the
+    same program)
+    -------------------------------------------------------------
+*/
+
+#include "sortkernel.h"
+
+#define SMOOTHSORT_LARGE_MIN  (1UL<<17)  // 1 MB of doubles
+
+#ifdef KERNEL_64
+#define MASK_BITS  128
+static const uint64_t L[] =     // Leonardo numbers in [0,1<<64)
+#else
+#define MASK_BITS  64
+static const uint32_t L[] =     // Leonardo numbers in [0,1<<32)
+#endif
+{
+    1UL, 1UL, 3UL, 5UL, 9UL, 15UL, 25UL, 41UL, 67UL, 109UL, 177UL,
+    287UL, 465UL, 753UL, 1219UL, 1973UL, 3193UL, 5167UL, 8361UL,
+    13529UL, 21891UL, 35421UL, 57313UL, 92735UL, 150049UL,
+    242785UL, 392835UL, 635621UL, 1028457UL, 1664079UL, 2692537UL,
+    4356617UL, 7049155UL, 11405773UL, 18454929UL, 29860703UL,
+    48315633UL, 78176337UL, 126491971UL, 204668309UL, 331160281UL,
+    535828591UL, 866988873UL, 1402817465UL, 2269806339UL,
+    3672623805UL
+#ifdef KERNEL_64
+  , 5942430145ULL, 9615053951ULL, 15557484097ULL, 25172538049ULL,
+    40730022147ULL, 65902560197ULL, 106632582345ULL,
+    172535142543ULL, 279167724889ULL, 451702867433ULL,
+    730870592323ULL, 1182573459757ULL, 1913444052081ULL,
+    3096017511839ULL, 5009461563921ULL, 8105479075761ULL,
+    13114940639683ULL, 21220419715445ULL, 34335360355129ULL,
+    55555780070575ULL, 89891140425705ULL, 145446920496281ULL,
+    235338060921987ULL, 380784981418269ULL, 616123042340257ULL,
+    996908023758527ULL, 1613031066098785ULL, 2609939089857313ULL,
+    4222970155956099ULL, 6832909245813413ULL, 11055879401769513ULL,
+    17888788647582927ULL, 28944668049352441ULL,
+    46833456696935369ULL, 75778124746287811ULL,
+    122611581443223181ULL, 198389706189510993ULL,
+    321001287632734175ULL, 519390993822245169ULL,
+    840392281454979345ULL, 1359783275277224515ULL,
+    2200175556732203861ULL, 3559958832009428377ULL,
+    5760134388741632239ULL, 9320093220751060617ULL,
+    15080227609492692857ULL
+#endif
+};
+
+#define LEONARDO_NUMS  (sizeof(L) / sizeof(L[0]))
+
+#include "smoothsort_mask.h"
+
+typedef struct
+{
+    hsmask mask;   // Leo. nums. in use (sizes of existing heaps)
+    int offset;    // Add this to every bit's position ('mask'
+}                  // always ends with a '1' bit, so 'offset' is
+heapsizes;         // also the size of the smallest heap)
+
+#define HEAPSIZE(k)    L[k]           // A heap of order k>1 has
+#define LEAF(k)        ((k) < 2)      // children of orders k-1
+#define ONLY_CHILD(k)  0              // (left) and k-2 (right)
+#define LEFT(k)        ((k) - 1)
+#define RIGHT(k)       ((k) - 2)
+
+static inline heapsizes hs_first (void)
+{
+    heapsizes hsz;
+
+    hsz.mask = mask_one ();   // A heap of size L[1]
+    hsz.offset = 1;
+    return hsz;
+}
+
+static inline void hs_grow (heapsizes * hsz)
+{
+    if (MASK_LOW (hsz->mask) & 2)      // If possible (if
+    {                                  // contiguous Leonardo
+        hsz->mask = mask_shr (hsz->mask, 2);   // numbers), fuse
+        MASK_LOW (hsz->mask) |= 1;             // the last two
+        hsz->offset += 2;                      // heaps
+    }                              // Otherwise,
+    else if (hsz->offset == 1)     // if last heap has size L[1]
+    {
+        hsz->mask = mask_shl (hsz->mask, 1);   // the new is L[0]
+        MASK_LOW (hsz->mask) |= 1;
+        hsz->offset = 0;
+    }
+    else                           // Otherwise, new heap L[1]
+    {
+        hsz->mask = mask_shl (hsz->mask, hsz->offset-1);
+        MASK_LOW (hsz->mask) |= 1;
+        hsz->offset = 1;
+    }
+}
+
+static inline int hs_fused (heapsizes hsz, sortindex i, sortindex num)
+{
+        // The current heap will be fused in the future if:
+        //
+        //     a) The sizes of this heap and the previous are
+        //        contiguous Leonardo numbers AND there is at
+        //        least one more element in the array
+        //  OR
+        //     b) This heap has size L[x] where x>0 AND there
+        //        is still space for a heap of size L[x-1] and
+        //        one more element (L[x]+L[x-1]+1 --> L[x+1])
+        //
+        // (i+1+L[x-1] < num, written so that it can't overflow)
+
+    return ( (MASK_LOW (hsz.mask) & 2) &&
+             i+1 < num                 ) ||
+           ( hsz.offset > 0    &&
+             L[hsz.offset-1] < num-i-1 );
+}
+
+static inline int hs_single (heapsizes hsz)
+{
+    return mask_single (hsz.mask);
+}
+
+static inline void hs_drop (heapsizes * hsz)
+{
+    int z;                         // Remove the last heap and skip
+                                   // the sizes not in use (the
+    MASK_LOW (hsz->mask) &= ~1ULL;  // mask will never be 0 here)
+    z = mask_skip (&hsz->mask);
+    hsz->offset += z;
+}
+
+static inline int hs_split (heapsizes * hsz, sortindex i,
+                            sortindex ch[2], heapsizes st[2])
+{
+    int j;
+
+    ch[1] = i - 1;                    // Position of right
+    ch[0] = ch[1] - L[hsz->offset-2]; // and left children
+
+    MASK_LOW (hsz->mask) &= ~1ULL;    // Remove current heap
+
+    for (j=0; j<2; j++)               // Add the children to the
+    {                                 // list (left first)
+        hsz->mask = mask_shl (hsz->mask, 1);
+        MASK_LOW (hsz->mask) |= 1;
+        hsz->offset --;
+        st[j] = *hsz;
+    }
+
+    return 0;
+}
+
+#undef MASK_LOW
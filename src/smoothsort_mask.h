@@ -0,0 +1,153 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    smoothsort_mask.h
+
+    The mask of the list of heaps of smoothsort: the bit k is set
+    if there is a heap of order offset+k (see the families of
+    heap sizes, smoothsort_leonardo.h, smoothsort_fib_1.h and
+    smoothsort_pow2_1.h). This is not a regular header: every
+    family includes it, with MASK_BITS defined as the number of
+    bits it needs (32, 64 or 128). It defines:
+
+        hsmask           Type of the mask
+        mask_one ()      A mask with just the bit 0 set
+        MASK_LOW(m)      The lowest (up to 64) bits of m, where
+                         the bits 0 and 1 are tested and changed
+        mask_shl (m, n)  m << n   (0 <= n < MASK_BITS)
+        mask_shr (m, n)  m >> n   (0 <= n < MASK_BITS)
+        mask_skip (&m)   Shifts out the trailing zeros of m (not
+                         0) and returns their number
+        mask_single (m)  m == 1
+
+    There can be heaps of orders 0 and 1 at the same time as the
+    largest one. With 64 bit positions (KERNEL_64, see
+    sortkernel.h) the Leonardo numbers go up to order 91, so the
+    mask is made of two uint64_t (128 bits) then
+    -------------------------------------------------------------
+*/
+
+#include "bitops.h"
+
+#if MASK_BITS > 64
+
+typedef struct
+{
+    uint64_t lo;   // 128 bit mask: 'lo' holds the 64 lower bits
+    uint64_t hi;
+}
+hsmask;
+
+#define MASK_LOW(m)  ((m).lo)
+
+static inline hsmask mask_one (void)
+{
+    hsmask m;
+
+    m.lo = 1;
+    m.hi = 0;
+    return m;
+}
+
+static inline hsmask mask_shl (hsmask m, int n)
+{
+    if (n < 64)
+    {
+        m.hi = (m.hi << n) | (m.lo >> (63-n) >> 1);
+        m.lo <<= n;
+    }
+    else
+    {
+        m.hi = m.lo << (n-64);
+        m.lo = 0;
+    }
+
+    return m;
+}
+
+static inline hsmask mask_shr (hsmask m, int n)
+{
+    if (n < 64)
+    {
+        m.lo = (m.lo >> n) | (m.hi << (63-n) << 1);
+        m.hi >>= n;
+    }
+    else
+    {
+        m.lo = m.hi >> (n-64);
+        m.hi = 0;
+    }
+
+    return m;
+}
+
+static inline int mask_skip (hsmask * m)
+{
+    int z;
+
+    if (m->lo)
+    {
+        z = ctz64 (m->lo);
+        m->lo = (m->lo >> z) | (m->hi << (63-z) << 1);
+        m->hi >>= z;
+        return z;
+    }
+
+    z = ctz64 (m->hi);
+    m->lo = m->hi >> z;
+    m->hi = 0;
+    return 64 + z;
+}
+
+static inline int mask_single (hsmask m)
+{
+    return m.lo == 1 && !m.hi;
+}
+
+#else // MASK_BITS <= 64
+
+#if MASK_BITS > 32
+typedef uint64_t hsmask;
+#define MASK_CTZ  ctz64
+#else
+typedef uint32_t hsmask;
+#define MASK_CTZ  ctz32
+#endif
+
+#define MASK_LOW(m)  (m)
+
+static inline hsmask mask_one (void)
+{
+    return 1;
+}
+
+static inline hsmask mask_shl (hsmask m, int n)
+{
+    return m << n;
+}
+
+static inline hsmask mask_shr (hsmask m, int n)
+{
+    return m >> n;
+}
+
+static inline int mask_skip (hsmask * m)
+{
+    int z = MASK_CTZ (*m);
+
+    *m >>= z;
+    return z;
+}
+
+static inline int mask_single (hsmask m)
+{
+    return m == 1;
+}
+
+#undef MASK_CTZ
+
+#endif // MASK_BITS
+
+#undef MASK_BITS
@@ -0,0 +1,53 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    smoothsort_payload.c
+
+    Version of smoothsort() that sorts an array of keys A[] and
+    moves a parallel array of payloads P[] (e.g. row ids) in
+    lock-step: after the sort, P[i] is still the payload of A[i].
+
+    The code is the same as in smoothsort.c (see the comments
+    there): smoothsort_engine.h and smoothsort_leonardo.h,
+    included with KERNEL_PAYLOAD defined (see sortkernel.h). The
+    comparisons only read the keys. Every move of a key in
+    sift_in() and interheap_sift(), including the chained swaps,
+    is done with its payload too, and large arrays are sorted
+    with the prefetching sifts
+    ---------------------------------------------------------------
+*/
+
+#define KERNEL_PAYLOAD
+
+#include "sorting.h"
+#include "smoothsort_leonardo.h"
+#include "smoothsort_engine.h"
+
+#define ENGINE(x)  x##_large    // Versions for large arrays
+#define ENGINE_PREFETCH
+#include "smoothsort_engine.h"
+
+void smoothsort_payload (
+                sorteddatatype A[],        // Array to be sorted
+                payloadtype P[],           // Payloads of A[]
+                uint32_t num)              // Size of the arrays
+{
+    heapsizes hsz;
+    PAYLOAD_INIT
+
+    if (num < 2)
+        return;
+
+    if (num >= SMOOTHSORT_LARGE_MIN)
+    {
+        hsz = heapify_large (A, num, pay);
+        extract_large (A, num, hsz, 1, pay);
+        return;
+    }
+
+    hsz = heapify (A, num, pay);
+
+    extract (A, num, hsz, 1, pay);
+}
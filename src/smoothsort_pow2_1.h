@@ -0,0 +1,132 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    smoothsort_pow2_1.h
+
+    The family of heap sizes of smoothsort_pow2_1.c (the powers
+    of two minus one) and the rules to update the list of heaps,
+    as required by smoothsort_engine.h. Included by
+    smoothsort_pow2_1.c, smoothsort_pow2_1_64.c (with KERNEL_64,
+    for a 64 bit mask, see sortkernel.h) and sorting.hpp. The
+    mask is an integer in both cases, so it is shifted with the
+    operators
+    -------------------------------------------------------------
+*/
+
+#include "sortkernel.h"
+
+#ifdef KERNEL_64
+#define MASK_BITS  64
+#else
+#define MASK_BITS  32
+#endif
+#include "smoothsort_mask.h"
+
+typedef struct
+{
+    hsmask mask;   // Heap sizes in use (sizes of existing heaps)
+
+                   // Add this to every bit's position ('mask'
+    short offset;  // always ends with a '1' bit, so 'offset' is
+                   // also the size of the smallest heap)
+
+    char bis;      // 1="There is another heap of size 'offset'"
+}
+heapsizes;
+
+#define HEAPSIZE(k)    (((sortindex)2<<(k))-1)  // A heap of order
+#define LEAF(k)        ((k) < 1)      // k>0 has two children of
+#define ONLY_CHILD(k)  0              // order k-1
+#define LEFT(k)        ((k) - 1)
+#define RIGHT(k)       ((k) - 1)
+
+static inline heapsizes hs_first (void)
+{
+    heapsizes hsz;
+
+    hsz.mask = 1;             // A heap of size 0
+    hsz.offset = 0;
+    hsz.bis = 0;
+    return hsz;
+}
+
+static inline void hs_grow (heapsizes * hsz)
+{
+    if (hsz->bis)             // If possible (contiguous heaps
+    {                                     // of same size),
+        hsz->bis  = (hsz->mask>>1) & 1;   // fuse last two heaps
+        hsz->mask = (hsz->mask>>1) | 1;
+        hsz->offset ++;
+    }                         // Otherwise,
+    else if (hsz->offset == 0)  // if last heap has size 0
+    {
+        hsz->bis = 1;           // Make another (the 'bis')
+    }
+    else       // Otherwise, just append a heap of size 0
+    {
+        hsz->mask = (hsz->mask << hsz->offset) | 1;
+        hsz->offset = 0;
+    }
+}
+
+static inline int hs_fused (heapsizes hsz, sortindex i, sortindex num)
+{
+        // The current heap will be fused in the future if:
+        //
+        //     a) The sizes of this heap and the previous are
+        //        equal AND there is at least one more element
+        //        in the array
+        //  OR
+        //     b) There is still space in the array for
+        //        another heap of the same size plus one more
+        //        element
+        //
+        // (i+2^(offset+1) < num, written so that it can't
+        // overflow)
+
+    return hsz.bis ? i+1 < num                                 :
+                     ((sortindex)1<<hsz.offset) <= (num-i-1)>>1;
+}
+
+static inline int hs_single (heapsizes hsz)
+{
+    return !hsz.bis && hsz.mask == 1;
+}
+
+static inline void hs_drop (heapsizes * hsz)
+{
+    int z;
+
+    if (hsz->bis)                  // Remove the 'bis' heap or
+        hsz->bis = 0;              // skip the sizes not in use
+    else                           // (the mask will never be 0
+    {                              // here)
+        hsz->mask &= ~(hsmask)1;
+        z = mask_skip (&hsz->mask);
+        hsz->offset += z;
+    }
+}
+
+static inline int hs_split (heapsizes * hsz, sortindex i,
+                            sortindex ch[2], heapsizes st[2])
+{
+    ch[1] = i - 1;                          // Position of right
+    ch[0] = i - ((sortindex)1<<hsz->offset);   // and left children
+
+    if (!hsz->bis)
+        hsz->mask &= ~1UL;
+
+    hsz->mask = (hsz->mask << 1) | 1;
+    hsz->offset --;
+                        // Convert current heap in two smaller
+    hsz->bis = 0;       // heaps. The list ending in the left one
+    st[0] = *hsz;       // has only one of that size
+    hsz->bis = 1;
+    st[1] = *hsz;
+
+    return 0;
+}
+
+#undef MASK_LOW
@@ -0,0 +1,34 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    smoothsort_pow2_1_64.c
+
+    Version of smoothsort_pow2_1() for arrays of more than 4G
+    elements. The algorithm is the same as in smoothsort_pow2_1.c
+    (see the comments there), and so is the code:
+    smoothsort_engine.h and smoothsort_pow2_1.h, included with
+    KERNEL_64 defined (see sortkernel.h). The positions are size_t
+    values and the mask of heap sizes is an uint64_t, which is
+    enough for heaps of up to 2^64-1 elements
+    ---------------------------------------------------------------
+*/
+
+#define KERNEL_64
+
+#include "sorting.h"
+#include "smoothsort_pow2_1.h"
+#include "smoothsort_engine.h"
+
+void smoothsort_pow2_1_64 (sorteddatatype A[], size_t num)
+{
+    heapsizes hsz;
+
+    if (num < 2)  // If there's only one element, it's done.
+        return;   // The other functions assume 2 or more elements
+
+    hsz = heapify (A, num);   // Build the ordered list of heaps
+
+    extract (A, num, hsz, 1); // Consume the list of heaps. When
+}                             // only two remain, it's done
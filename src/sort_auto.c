@@ -0,0 +1,198 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    sort_auto.c
+
+    Adaptive sort: sort_auto() looks at the array before choosing
+    the algorithm. The probe has three steps:
+
+       1) SAMPLE: PROBE_BLOCKS blocks of PROBE_PAIRS consecutive
+          pairs, evenly spread over the array, are scanned for
+          descents (A[i+1] < A[i]) and for breaks of monotone runs
+          (see below). If breaks are frequent, the array has no
+          long runs, and the next step is skipped. Arrays of less
+          than PROBE_MIN elements skip this step: the next one is
+          cheap enough for them
+
+       2) RUNS: Otherwise, the whole array is scanned counting
+          its monotone runs (non-descending or strictly
+          descending, like mergesort_natural() does). The scan
+          stops as soon as the runs are too short on average, so
+          this step is O(N) with a tiny constant
+
+       3) DUPLICATES: Only if the statistics are asked for (see
+          below), PROBE_SAMPLE elements (or N/16, if it is less)
+          spread over the array are sorted, and the equal
+          neighbours are counted
+
+    Then it dispatches:
+
+        * Up to SORTNET_MAX elements: sortnet()
+
+        * Runs of RUN_MIN elements or more on average (sorted,
+          reversed, nearly sorted, sorted with some elements
+          appended, sawtooth...): mergesort_natural(), which
+          merges the existing runs and takes O(N) time when
+          there are few of them
+
+        * Otherwise: radixsort(), that is O(N) for any data (it
+          uses quicksort() for small arrays by itself)
+
+    The thresholds come from the benchmark (see bench/). Note that
+    smoothsort() is also O(N) for sorted data, but the natural
+    merge sort is faster on every presorted input measured, and
+    duplicates didn't change the best choice for any size. So the
+    ratio of duplicates is reported but doesn't take part in the
+    decision, and sort_auto() doesn't spend time measuring it.
+
+    sort_auto_probe() does the same and returns the statistics of
+    the probe and the name of the algorithm chosen. Compiling with
+    SORT_AUTO_LOG defined, every call to sort_auto() prints them
+    on stderr
+    ---------------------------------------------------------------
+*/
+
+#ifdef SORT_AUTO_LOG
+#include <stdio.h>
+#endif
+
+#include "sorting.h"
+
+#define PROBE_BLOCKS   64    // Blocks scanned by the sample
+#define PROBE_PAIRS    32    // Consecutive pairs per block
+#define PROBE_SAMPLE  256    // Elements sampled for duplicates
+#define PROBE_MIN   16384    // Smaller arrays skip the sample
+#define RUN_MIN        32    // Min. average run for merging
+
+static void probe_sample (const sorteddatatype A[], uint32_t num,
+                          sortprobe * p);
+
+static uint32_t count_runs (const sorteddatatype A[], uint32_t num,
+                            uint32_t max);
+
+static double duplicates (const sorteddatatype A[], uint32_t num);
+
+void sort_auto (sorteddatatype A[],        // Array to be sorted
+                uint32_t num)              // Size of the array
+{
+#ifndef SORT_AUTO_LOG
+    sort_auto_probe (A, num, NULL);
+#else
+    sortprobe p;
+
+    sort_auto_probe (A, num, &p);
+
+    fprintf (stderr, "sort_auto: num=%lu sampled=%lu descents=%lu "
+             "breaks=%lu runs=%lu duplicates=%.3f -> %s\n",
+             (unsigned long) num, (unsigned long) p.sampled,
+             (unsigned long) p.descents, (unsigned long) p.breaks,
+             (unsigned long) p.runs, p.duplicates, p.algorithm);
+#endif
+}
+
+void sort_auto_probe (
+                sorteddatatype A[],        // Array to be sorted
+                uint32_t num,              // Size of the array
+                sortprobe * probe)         // Statistics (or NULL)
+{
+    sortprobe p;
+
+    p.sampled = p.descents = p.breaks = p.runs = 0;
+    p.duplicates = 0;
+
+    if (num <= SORTNET_MAX)
+    {
+        p.algorithm = "sortnet";
+        sortnet (A, num);
+    }
+    else
+    {
+        if (num >= PROBE_MIN)
+            probe_sample (A, num, &p);
+        if (probe)                        // (Only reported)
+            p.duplicates = duplicates (A, num);
+                                          // If the sample shows
+        if (p.breaks * 8 <= p.sampled)    // long runs (or there is
+            p.runs = count_runs (A, num, num / RUN_MIN);  // no
+                                          // sample), count them
+
+        if (p.runs > 0 && p.runs <= num / RUN_MIN)
+        {
+            p.algorithm = "mergesort_natural";
+            mergesort_natural (A, num);
+        }
+        else
+        {
+            p.algorithm = "radixsort";
+            radixsort (A, num);
+        }
+    }
+
+    if (probe)
+        *probe = p;
+}
+
+static void probe_sample (const sorteddatatype A[], uint32_t num,
+                          sortprobe * p)
+{
+    uint32_t b, i, end;
+
+    for (b=0; b<PROBE_BLOCKS; b++)
+    {
+        i = (uint32_t) (((uint64_t)b * (num - PROBE_PAIRS - 1))
+                        / (PROBE_BLOCKS - 1));
+        end = i + PROBE_PAIRS;
+
+        p->sampled += PROBE_PAIRS;
+        p->breaks += count_runs (A+i, PROBE_PAIRS+1, PROBE_PAIRS) - 1;
+
+        for (; i<end; i++)
+            p->descents += A[i+1] < A[i];
+    }
+}
+
+static uint32_t count_runs (const sorteddatatype A[], uint32_t num,
+                            uint32_t max)
+{                                  // Num. of runs, or max+1 if
+    uint32_t runs, i;              // there are more than max
+
+    runs = 0;
+    i = 0;
+
+    while (i < num)
+    {
+        if (++runs > max)
+            break;
+
+        i ++;
+
+        if (i < num && A[i] < A[i-1])          // Strictly
+            while (++i < num && A[i] < A[i-1])  // descending
+                ;
+        else                                   // Non-descending
+            while (i < num && !(A[i] < A[i-1]))
+                i ++;
+    }
+
+    return runs;
+}
+
+static double duplicates (const sorteddatatype A[], uint32_t num)
+{
+    sorteddatatype S[PROBE_SAMPLE];
+    uint32_t n, i, eq;
+
+    n = num/16 < PROBE_SAMPLE ? num/16 : PROBE_SAMPLE;
+
+    for (i=0; i<n; i++)
+        S[i] = A[(uint32_t) (((uint64_t)i * num) / n)];
+
+    quicksort (S, n);
+
+    for (i=1, eq=0; i<n; i++)   // Ratio of values equal to the
+        eq += S[i] == S[i-1];   // previous one in the sorted
+                                // sample
+    return n > 1 ? (double) eq / (n-1) : 0;
+}
@@ -0,0 +1,212 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    sort_batch.c
+
+    Sorting of many independent arrays in one call. sort_batch()
+    takes a list of (pointer, length) pairs and sorts every array
+    with the kernel that suits its size:
+
+        * Up to SORTNET_MAX elements: sortnet()
+        * Up to BATCH_QUICK_MAX elements: quicksort()
+        * Larger arrays: sort_auto(), that looks at the data
+
+    The work is spread over a work-stealing pool (see workpool.h)
+    in TASKS_PER_THREAD tasks per thread. Every array costs about
+    N log2 N, and the list is cut in consecutive groups of
+    arrays of similar total cost, so that thousands of tiny
+    arrays make a single task and a large array makes a task by
+    itself. The tasks are submitted from the most expensive to the
+    cheapest. The pool starts the tasks submitted from outside in
+    that same order, so the large ones start first and the small
+    ones fill the gaps, taken by whatever thread gets idle.
+
+    If the batch is small (less than BATCH_SERIAL_MIN elements in
+    total), there is only one thread, or the pool can't be
+    created, the arrays are sorted in the calling thread.
+
+    sort_batch() creates the pool and destroys it at the end of
+    every call, which costs more than sorting a small batch. A
+    caller that sorts batch after batch can create the pool once
+    with workpool_create() and pass it to sort_batch_pool()
+    instead (NULL: sort in the calling thread). The pool must not
+    run other work at the same time, since workpool_wait() waits
+    for all of its tasks.
+
+    Optionally, it returns the number of arrays and elements, the
+    time taken and the throughput in arrays/s and elements/s
+    ---------------------------------------------------------------
+*/
+
+#define _POSIX_C_SOURCE 199309L     // For clock_gettime()
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "sorting.h"
+#include "workpool.h"
+
+#define BATCH_QUICK_MAX    4096     // Larger arrays use sort_auto()
+#define BATCH_SERIAL_MIN  65536     // Sort smaller batches serially
+#define TASKS_PER_THREAD     16
+
+typedef struct
+{
+    sortarray * arrays;       // Group of consecutive arrays
+    size_t      count;
+    uint64_t    cost;         // Sum of N log2 N
+}
+batchtask;
+
+static inline double seconds (void)
+{
+    struct timespec t;
+
+    clock_gettime (CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static inline uint64_t cost (uint32_t num)
+{
+    uint64_t c;                    // About num*log2(num), and at
+    int bits;                      // least 1 (even empty arrays
+                                   // take some time)
+    for (bits=1; num>>bits; bits++)
+        ;
+
+    c = (uint64_t)num * bits;
+    return c ? c : 1;
+}
+
+static inline void sort_one (sorteddatatype A[], uint32_t num)
+{
+    if (num <= SORTNET_MAX)
+        sortnet (A, num);
+    else if (num <= BATCH_QUICK_MAX)
+        quicksort (A, num);
+    else
+        sort_auto (A, num);
+}
+
+static void sort_group (void * arg)
+{
+    batchtask * t = (batchtask *) arg;
+    size_t i;
+
+    for (i=0; i<t->count; i++)
+        sort_one (t->arrays[i].A, t->arrays[i].num);
+}
+
+static int by_cost (const void * a, const void * b)
+{
+    uint64_t x = ((const batchtask *)a)->cost;
+    uint64_t y = ((const batchtask *)b)->cost;
+
+    return x < y ? 1 : x > y ? -1 : 0;       // Expensive first
+}
+
+void sort_batch (sortarray arrays[],       // Arrays to be sorted
+                 size_t count,             // Number of arrays
+                 int nthreads,             // Threads (<1: one per
+                                           // processor)
+                 sortbatch_stats * stats)  // Stats (or NULL)
+{
+    workpool * pool;
+    uint64_t elements;
+    size_t i;
+
+    if (nthreads < 1)
+        nthreads = workpool_processors ();
+
+    for (i=0, elements=0; i<count; i++)
+        elements += arrays[i].num;
+
+    pool = NULL;
+    if (nthreads > 1 && elements >= BATCH_SERIAL_MIN)
+        pool = workpool_create (nthreads);
+
+    sort_batch_pool (arrays, count, pool, stats);
+
+    if (pool)
+        workpool_destroy (pool);
+}
+
+void sort_batch_pool (
+                 sortarray arrays[],       // Arrays to be sorted
+                 size_t count,             // Number of arrays
+                 workpool * pool,          // Caller's pool (or NULL)
+                 sortbatch_stats * stats)  // Stats (or NULL)
+{
+    batchtask * tasks;
+    uint64_t elements, total, target;
+    size_t i;
+    int nthreads, ntasks, maxtasks, t;
+    double t0;
+
+    t0 = seconds ();
+
+    nthreads = pool ? workpool_threads (pool) : 1;
+    elements = total = 0;
+
+    for (i=0; i<count; i++)
+    {
+        elements += arrays[i].num;
+        total += cost (arrays[i].num);
+    }
+
+    tasks = NULL;
+    ntasks = 0;
+    maxtasks = nthreads * TASKS_PER_THREAD;
+
+    if (nthreads > 1 && elements >= BATCH_SERIAL_MIN)
+        tasks = malloc (maxtasks * sizeof(batchtask));
+
+    if (tasks)
+    {                                   // Cut the list in groups
+        target = total / maxtasks + 1;  // of at least 'target'
+                                        // (so there are at most
+        for (i=0; i<count; i++)         // 'maxtasks' groups)
+        {
+            if (ntasks == 0 || tasks[ntasks-1].cost >= target)
+            {
+                tasks[ntasks].arrays = arrays + i;
+                tasks[ntasks].count = 0;
+                tasks[ntasks].cost = 0;
+                ntasks ++;
+            }
+
+            tasks[ntasks-1].count ++;
+            tasks[ntasks-1].cost += cost (arrays[i].num);
+        }
+
+        qsort (tasks, ntasks, sizeof(batchtask), by_cost);
+
+        for (t=0; t<ntasks; t++)        // Started in this order
+            workpool_submit (pool, sort_group, tasks+t);
+
+        workpool_wait (pool);
+    }
+    else                                // Small batch, one thread
+    {                                   // or not enough memory
+        nthreads = 1;
+        for (i=0; i<count; i++)
+            sort_one (arrays[i].A, arrays[i].num);
+    }
+
+    free (tasks);
+
+    if (stats)
+    {
+        stats->arrays = count;
+        stats->elements = elements;
+        stats->threads = nthreads;
+        stats->tasks = ntasks;
+        stats->seconds = seconds () - t0;
+        stats->arrays_per_second = stats->seconds > 0 ?
+                                   count / stats->seconds : 0;
+        stats->elements_per_second = stats->seconds > 0 ?
+                                     elements / stats->seconds : 0;
+    }
+}
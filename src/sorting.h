@@ -14,13 +14,24 @@
 #define _SORTING_MKR_H_
 
 #include <stdint.h>
+#include <stddef.h>
 
 typedef double sorteddatatype;
 
+typedef void (*sortfunction) (sorteddatatype A[], uint32_t num);
+
+typedef uint64_t payloadtype;  // Moved along with the keys by the
+                               // *_payload() functions (use
+                               // uint32_t for 32 bit row ids)
+
 void combsort_cocktail_sqrt2_primes (
                     sorteddatatype A[],    // Array to be sorted
                     uint32_t len);         // Size of the array
 
+void combsort_cocktail_sqrt2_primes_simd (
+                    sorteddatatype A[],    // Array to be sorted
+                    uint32_t len);         // Size of the array
+
 void smoothsort (sorteddatatype A[],       // Array to be sorted
                  uint32_t num);            // Size of the array
 
@@ -31,6 +42,9 @@ void smoothsort_pow2_1 (
                     sorteddatatype A[],    // Array to be sorted
                     uint32_t len);         // Size of the array
 
+void poplarsort (sorteddatatype A[],       // Array to be sorted
+                 uint32_t num);            // Size of the array
+
 void bubblesort (sorteddatatype A[],       // Array to be sorted
                  uint32_t num);            // Size of the array
 
@@ -58,18 +72,314 @@ void insertionsort_biased_binary_search (
                  sorteddatatype A[],       // Array to be sorted
                  uint32_t num);            // Size of the array
 
+// The same, for an array whose first 'start' elements are sorted
+// already (use them on A+lo, hi-lo to sort a subrange)
+
+void insertionsort_simple_from (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num,             // Size of the array
+                 uint32_t start);          // A[0..start) is sorted
+
+void insertionsort_chained_swaps_from (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num,             // Size of the array
+                 uint32_t start);          // A[0..start) is sorted
+
+void insertionsort_binary_search_from (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num,             // Size of the array
+                 uint32_t start);          // A[0..start) is sorted
+
+void insertionsort_biased_binary_search_from (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num,             // Size of the array
+                 uint32_t start);          // A[0..start) is sorted
+
 void heapsort (sorteddatatype A[],         // Array to be sorted
                uint32_t num);              // Size of the array
 
 void heapsort_floyd (sorteddatatype A[],   // Array to be sorted
                      uint32_t num);        // Size of the array
 
+void heapsort_branchless (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t num);            // Size of the array
+
+void heapsort_4ary (sorteddatatype A[],    // Array to be sorted
+                    uint32_t num);         // Size of the array
+
+void heapsort_8ary (sorteddatatype A[],    // Array to be sorted
+                    uint32_t num);         // Size of the array
+
+void heapsort_weak (sorteddatatype A[],    // Array to be sorted
+                    uint32_t num);         // Size of the array
+
 void quicksort (sorteddatatype A[],        // Array to be sorted
                 uint32_t num);             // Size of the array
 
+// Partial sorts. partial_sort() puts the k smallest elements,
+// sorted, in A[0..k). smoothsort_top() puts the k greatest ones,
+// sorted, in A[num-k..num). nth_element() puts in A[k] the value
+// that would be there if A were sorted, with lesser/eq. values
+// before it and greater/eq. values after it
+
+void partial_sort (sorteddatatype A[],     // Array to be sorted
+                   uint32_t num,           // Size of the array
+                   uint32_t k);            // Elements to sort
+
+void smoothsort_top (sorteddatatype A[],   // Array to be sorted
+                     uint32_t num,         // Size of the array
+                     uint32_t k);          // Elements to sort
+
+void nth_element (sorteddatatype A[],      // Array to be sorted
+                  uint32_t num,            // Size of the array
+                  uint32_t k);             // Position to place
+
+// Smoothsort of a sorted prefix plus an appended tail. The heaps of
+// the prefix are computed, not built, and the part of the prefix
+// not greater than the tail is skipped (see smoothsort.c)
+
+void smoothsort_append (
+                 sorteddatatype A[],       // Array to be sorted
+                 uint32_t sorted_len,      // A[0..sorted_len) is sorted
+                 uint32_t num);            // Size of the array
+
+// Priority queue (max. first) made of the Leonardo heaps of
+// smoothsort, in place over a buffer owned by the caller. Popping
+// after smoothheap_heapify() is a lazy sorted iterator: it yields
+// the greatest elements first and leaves them at the end of A
+
+typedef struct
+{
+    sorteddatatype * A;   // Buffer (owned by the caller)
+    uint32_t capacity;    // Size of the buffer
+    uint32_t num;         // Elements in the queue: A[0..num)
+    uint64_t mask;        // Sizes of the heaps (see smoothsort.c)
+    int offset;
+}
+smoothheap;
+
+void smoothheap_init (smoothheap * q,      // Queue to initialize
+                      sorteddatatype A[],  // Buffer (caller owned)
+                      uint32_t capacity);  // Size of the buffer
+
+void smoothheap_heapify (
+                smoothheap * q,            // Queue to initialize
+                sorteddatatype A[],        // Elements (and buffer)
+                uint32_t num);             // Number of elements
+
+int smoothheap_sorted (
+                smoothheap * q,            // Queue to initialize
+                sorteddatatype A[],        // Buffer (caller owned)
+                uint32_t capacity,         // Size of the buffer
+                uint32_t num);             // A[0..num) is sorted
+                                           // (returns 0 if > capacity)
+
+int smoothheap_append (smoothheap * q,     // Queue
+                       uint32_t num);      // Elements in q->A
+                                           // (returns 0 if > capacity)
+
+int smoothheap_push (smoothheap * q,       // Queue
+                     sorteddatatype x);    // Element to insert
+                                           // (returns 0 if full)
+
+int smoothheap_peek (const smoothheap * q, // Queue
+                     sorteddatatype * x);  // Max. element (output)
+                                           // (returns 0 if empty)
+
+int smoothheap_pop (smoothheap * q,        // Queue
+                    sorteddatatype * x);   // Max. element (output)
+                                           // (returns 0 if empty)
+
 void quicksort_median_of_medians (
                  sorteddatatype A[],       // Array to be sorted
                  uint32_t num);            // Size of the array
 
+void radixsort (sorteddatatype A[],        // Array to be sorted
+                uint32_t num);             // Size of the array
+
+void radixsort_buffer (
+                sorteddatatype A[],        // Array to be sorted
+                uint32_t num,              // Size of the array
+                sorteddatatype B[]);       // Auxiliary array of
+                                           // 'num' elements (or
+                                           // NULL to allocate it)
+
+void mergesort_natural (
+                sorteddatatype A[],        // Array to be sorted
+                uint32_t num);             // Size of the array
+
+void mergesort_natural_buffer (
+                sorteddatatype A[],        // Array to be sorted
+                uint32_t num,              // Size of the array
+                sorteddatatype B[]);       // Scratch buffer of
+                                           // num/2 elements (or
+                                           // NULL to allocate it)
+
+#define SORTNET_MAX  64    // Max. size sorted by the networks
+
+void sortnet (sorteddatatype A[],          // Array to be sorted
+              uint32_t num);               // Size of the array
+
+void sortnet_merge (sorteddatatype A[],    // Array to be merged
+                    uint32_t num,          // Size of the array
+                    uint32_t mid);         // Start of 2nd half
+                                           // (both halves sorted)
+
+// Adaptive sort: probes the presortedness of the array and
+// dispatches to the best algorithm above (see sort_auto.c)
+
+typedef struct
+{
+    uint32_t sampled;     // Pairs of neighbours sampled
+    uint32_t descents;    // Sampled pairs with A[i+1] < A[i]
+    uint32_t breaks;      // Ends of monotone runs in the sample
+    uint32_t runs;        // Monotone runs (0: not counted)
+    double duplicates;    // Ratio of repeated values in a sample
+    const char * algorithm;   // Algorithm chosen
+}
+sortprobe;
+
+void sort_auto (sorteddatatype A[],        // Array to be sorted
+                uint32_t num);             // Size of the array
+
+void sort_auto_probe (
+                sorteddatatype A[],        // Array to be sorted
+                uint32_t num,              // Size of the array
+                sortprobe * probe);        // Statistics (or NULL)
+
+void parallel_sort (sorteddatatype A[],    // Array to be sorted
+                    uint32_t num,          // Size of the array
+                    int nthreads);         // Threads (<1: one per
+                                           // processor)
+
+void parallel_sort_kernel (
+                    sorteddatatype A[],    // Array to be sorted
+                    uint32_t num,          // Size of the array
+                    int nthreads,          // Threads (<1: one per
+                                           // processor)
+                    sortfunction kernel);  // Sort for every bucket
+
+void heapsort_parallel (
+                    sorteddatatype A[],    // Array to be sorted
+                    uint32_t num,          // Size of the array
+                    int nthreads);         // Threads (<1: one per
+                                           // processor)
+
+// Sorting of many independent arrays at once (see sort_batch.c)
+
+typedef struct
+{
+    sorteddatatype * A;   // Array to be sorted
+    uint32_t num;         // Size of the array
+}
+sortarray;
+
+typedef struct
+{
+    uint64_t arrays;      // Arrays sorted
+    uint64_t elements;    // Elements in all of them
+    int threads;          // Threads used
+    int tasks;            // Groups of arrays (0: sorted serially)
+    double seconds;       // Time taken
+    double arrays_per_second;
+    double elements_per_second;
+}
+sortbatch_stats;
+
+void sort_batch (sortarray arrays[],       // Arrays to be sorted
+                 size_t count,             // Number of arrays
+                 int nthreads,             // Threads (<1: one per
+                                           // processor)
+                 sortbatch_stats * stats); // Stats (or NULL)
+
+struct workpool;                           // See workpool.h
+
+void sort_batch_pool (                     // Same, in a pool created
+                 sortarray arrays[],       // by the caller with
+                 size_t count,             // workpool_create(), to
+                 struct workpool * pool,   // reuse it (NULL: sort in
+                 sortbatch_stats * stats); // the calling thread)
+
+// External sort of binary files of doubles larger than memory
+
+typedef struct
+{
+    size_t memory;        // Memory budget in bytes (0: default)
+    const char * tmpdir;  // Directory for the runs (NULL: ".")
+    sortfunction kernel;  // Sort of the runs (NULL: quicksort)
+    int verbose;          // Report every phase on stderr
+}
+extsort_options;
+
+typedef struct
+{
+    uint64_t elements;    // Elements sorted
+    uint32_t runs;        // Runs generated (0: sorted in memory)
+    uint32_t merges;      // K-way merges (the last one makes the
+                          // output)
+    double run_seconds;   // Time of each phase
+    double merge_seconds;
+    uint64_t run_bytes;   // Bytes read + written in each phase
+    uint64_t merge_bytes;
+}
+extsort_stats;
+
+int extsort (const char * input,           // File to sort
+             const char * output,          // Sorted file (may be
+                                           // the same as input)
+             const extsort_options * opt,  // NULL: defaults
+             extsort_stats * stats);       // Stats (or NULL)
+                                           // (1: OK, 0: see errno)
+
+// Variants that sort the keys A[] and move a parallel array of
+// payloads P[] in lock-step (P[i] stays with A[i]). Only the keys
+// are compared
+
+void heapsort_payload (sorteddatatype A[], // Array to be sorted
+                       payloadtype P[],    // Payloads of A[]
+                       uint32_t num);      // Size of the arrays
+
+void heapsort_floyd_payload (
+                sorteddatatype A[],        // Array to be sorted
+                payloadtype P[],           // Payloads of A[]
+                uint32_t num);             // Size of the arrays
+
+void heapsort_branchless_payload (
+                sorteddatatype A[],        // Array to be sorted
+                payloadtype P[],           // Payloads of A[]
+                uint32_t num);             // Size of the arrays
+
+void smoothsort_payload (
+                sorteddatatype A[],        // Array to be sorted
+                payloadtype P[],           // Payloads of A[]
+                uint32_t num);             // Size of the arrays
+
+// Variants for arrays of more than 4G elements. These take the
+// size as a size_t and use 64 bit indices and size tables. The
+// functions above remain the fastest choice for smaller arrays
+
+void smoothsort_64 (sorteddatatype A[],    // Array to be sorted
+                    size_t num);           // Size of the array
+
+void smoothsort_fib_1_64 (
+                    sorteddatatype A[],    // Array to be sorted
+                    size_t num);           // Size of the array
+
+void smoothsort_pow2_1_64 (
+                    sorteddatatype A[],    // Array to be sorted
+                    size_t num);           // Size of the array
+
+void heapsort_64 (sorteddatatype A[],      // Array to be sorted
+                  size_t num);             // Size of the array
+
+void heapsort_floyd_64 (
+                  sorteddatatype A[],      // Array to be sorted
+                  size_t num);             // Size of the array
+
+void heapsort_branchless_64 (
+                  sorteddatatype A[],      // Array to be sorted
+                  size_t num);             // Size of the array
+
 #endif // _SORTING_MKR_H_
 
@@ -0,0 +1,428 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    sorting.hpp
+
+    Header-only C++ front-end of the sorting functions. The C
+    implementations are hard-wired to 'sorteddatatype' and to the
+    operator '<'. The templates below take the element type T and
+    a comparison object 'less' as template parameters:
+
+        sorting::heapsort (A, num);              // uses std::less
+        sorting::heapsort (A, num, MyLess());    // custom order
+
+    They are not a copy of the C code. The kernels of heap sort,
+    insertion sort, merge sort and smoothsort are written once,
+    with the macros of sortkernel.h, and both the C files and this
+    header include them (see heapsort_kernel.h,
+    insertionsort_kernel.h, mergesort_kernel.h and
+    smoothsort_engine.h). Here they are included inside of a class
+    template, with LESS(a,b) defined as less(a,b), so they become
+    member functions that see the comparison object. Since it is
+    a template parameter, the compiler can inline it. There is no
+    indirect call per comparison (as in qsort()), so the sifts run
+    as fast as in the C version with 'double'. The comparison must
+    be a strict weak ordering, and must not throw.
+
+    The elements are moved with std::move(), so they only need to
+    be movable (and move-assignable), except in
+    heapsort_branchless(), that copies some of them (see
+    heapsort_kernel.h). They need not be default-constructible.
+
+    sorting::mergesort_natural() is stable, so it is the one to
+    use for sorting records by several keys, one pass per key. Its
+    scratch buffer is raw memory: the elements are constructed in
+    it while they are merged, and destroyed afterwards. A buffer
+    passed by the caller must have room for num/2 elements, with
+    none of them constructed (e.g. from ::operator new()).
+
+    The sifts count comparisons and moves if SORTING_STATS is
+    defined (see sortstats.h). The counters are defined in
+    sortstats.c, so then the program must be linked with it.
+
+    The C entry points in sorting.h remain available for plain C
+    callers. They are the same kernels, instantiated for
+    'sorteddatatype' and the operator '<'
+    ---------------------------------------------------------------
+*/
+
+#ifndef _SORTING_MKR_HPP_
+#define _SORTING_MKR_HPP_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "sortstats.h"      // Included here, so that the #includes
+#include "prefetch.h"       // of the kernels, inside the classes
+#include "bitops.h"         // below, do nothing
+
+#define LESS(a,b)          less (a, b)
+#define LESS_EQ(a,b)       (!less (b, a))
+#define MOVE(x)            std::move (x)
+#define MOVE_LEFT(d,s,n)   std::move (s, (s)+(n), d)
+#define MOVE_RIGHT(d,s,n)  std::move_backward (s, (s)+(n), (d)+(n))
+#define BUF_ALLOC(n)       ::operator new ((n) * sizeof(sorteddatatype), \
+                                           std::nothrow)
+#define BUF_FREE(p)        ::operator delete (p)
+#define BUF_FILL(p,s,n)    std::uninitialized_copy (                    \
+                                std::make_move_iterator (s),            \
+                                std::make_move_iterator ((s)+(n)), p)
+#define BUF_CLEAR(p,n)     destroy_buffer (p, n)
+#define KERNEL_STATIC
+
+#include "sortkernel.h"     // (keeps the definitions above)
+
+namespace sorting
+{
+
+namespace detail
+{
+
+template <typename T>
+inline void destroy_buffer (T * p, uint32_t n)
+{
+    for (; n; n--, p++)
+        p->~T();
+}
+
+// ----------------------------------------------------------------
+//  Heap sort, insertion sort and merge sort
+// ----------------------------------------------------------------
+
+template <typename T, typename Compare>
+struct kernels
+{
+    typedef T sorteddatatype;
+
+    Compare less;
+
+#include "heapsort_kernel.h"
+#include "insertionsort_kernel.h"
+#include "mergesort_kernel.h"
+};
+
+// ----------------------------------------------------------------
+//  Smoothsort, with the three families of heap sizes
+// ----------------------------------------------------------------
+
+namespace leonardo
+{
+
+#include "smoothsort_leonardo.h"
+
+template <typename T, typename Compare>
+struct smooth
+{
+    typedef T sorteddatatype;
+
+    Compare less;
+
+#include "smoothsort_engine.h"
+
+#define ENGINE(x)  x##_large    // Versions for large arrays
+#define ENGINE_PREFETCH
+#include "smoothsort_engine.h"
+
+    void sort (sorteddatatype A[], uint32_t num)   // As in
+    {                                              // smoothsort.c
+        if (num < 2)
+            return;
+
+        if (num >= SMOOTHSORT_LARGE_MIN)
+            extract_large (A, num, heapify_large (A, num), 1);
+        else
+            extract (A, num, heapify (A, num), 1);
+    }
+};
+
+} // namespace leonardo
+
+#undef HEAPSIZE
+#undef LEAF
+#undef ONLY_CHILD
+#undef LEFT
+#undef RIGHT
+#undef LEONARDO_NUMS
+#undef SMOOTHSORT_LARGE_MIN
+
+namespace fib_1
+{
+
+#include "smoothsort_fib_1.h"
+
+template <typename T, typename Compare>
+struct smooth
+{
+    typedef T sorteddatatype;
+
+    Compare less;
+
+#include "smoothsort_engine.h"
+
+    void sort (sorteddatatype A[], uint32_t num)   // As in
+    {                                              // smoothsort_fib_1.c
+        if (num < 2)
+            return;
+
+        extract (A, num, heapify (A, num), 2);
+    }
+};
+
+} // namespace fib_1
+
+#undef HEAPSIZE
+#undef LEAF
+#undef ONLY_CHILD
+#undef LEFT
+#undef RIGHT
+
+namespace pow2_1
+{
+
+#include "smoothsort_pow2_1.h"
+
+template <typename T, typename Compare>
+struct smooth
+{
+    typedef T sorteddatatype;
+
+    Compare less;
+
+#include "smoothsort_engine.h"
+
+    void sort (sorteddatatype A[], uint32_t num)   // As in
+    {                                              // smoothsort_pow2_1.c
+        if (num < 2)
+            return;
+
+        extract (A, num, heapify (A, num), 1);
+    }
+};
+
+} // namespace pow2_1
+
+#undef HEAPSIZE
+#undef LEAF
+#undef ONLY_CHILD
+#undef LEFT
+#undef RIGHT
+
+} // namespace detail
+
+// ----------------------------------------------------------------
+//  Public templates
+// ----------------------------------------------------------------
+
+template <typename T, typename Compare>
+void heapsort (T A[],              // Array to be sorted
+               uint32_t num,       // Size of the array
+               Compare less)       // Strict weak ordering
+{
+    detail::kernels<T, Compare> k = { less };
+    k.heapsort (A, num);
+}
+
+template <typename T, typename Compare>
+void heapsort_floyd (T A[],        // Array to be sorted
+                     uint32_t num, // Size of the array
+                     Compare less) // Strict weak ordering
+{
+    detail::kernels<T, Compare> k = { less };
+    k.heapsort_floyd (A, num);
+}
+
+template <typename T, typename Compare>
+void heapsort_branchless (
+                 T A[],            // Array to be sorted
+                 uint32_t num,     // Size of the array
+                 Compare less)     // Strict weak ordering
+{
+    detail::kernels<T, Compare> k = { less };
+    k.heapsort_branchless (A, num);
+}
+
+template <typename T, typename Compare>
+void insertionsort_simple (
+                 T A[],            // Array to be sorted
+                 uint32_t num,     // Size of the array
+                 Compare less)     // Strict weak ordering
+{
+    detail::kernels<T, Compare> k = { less };
+    k.insertionsort_simple (A, num);
+}
+
+template <typename T, typename Compare>
+void insertionsort_chained_swaps (
+                 T A[],            // Array to be sorted
+                 uint32_t num,     // Size of the array
+                 Compare less)     // Strict weak ordering
+{
+    detail::kernels<T, Compare> k = { less };
+    k.insertionsort_chained_swaps (A, num);
+}
+
+template <typename T, typename Compare>
+void insertionsort_binary_search (
+                 T A[],            // Array to be sorted
+                 uint32_t num,     // Size of the array
+                 Compare less)     // Strict weak ordering
+{
+    detail::kernels<T, Compare> k = { less };
+    k.insertionsort_binary_search (A, num);
+}
+
+template <typename T, typename Compare>
+void insertionsort_biased_binary_search (
+                 T A[],            // Array to be sorted
+                 uint32_t num,     // Size of the array
+                 Compare less)     // Strict weak ordering
+{
+    detail::kernels<T, Compare> k = { less };
+    k.insertionsort_biased_binary_search (A, num);
+}
+
+template <typename T, typename Compare>
+void smoothsort (T A[],            // Array to be sorted
+                 uint32_t num,     // Size of the array
+                 Compare less)     // Strict weak ordering
+{
+    detail::leonardo::smooth<T, Compare> s = { less };
+    s.sort (A, num);
+}
+
+template <typename T, typename Compare>
+void smoothsort_fib_1 (T A[],           // Array to be sorted
+                       uint32_t num,    // Size of the array
+                       Compare less)    // Strict weak ordering
+{
+    detail::fib_1::smooth<T, Compare> s = { less };
+    s.sort (A, num);
+}
+
+template <typename T, typename Compare>
+void smoothsort_pow2_1 (T A[],          // Array to be sorted
+                        uint32_t num,   // Size of the array
+                        Compare less)   // Strict weak ordering
+{
+    detail::pow2_1::smooth<T, Compare> s = { less };
+    s.sort (A, num);
+}
+
+template <typename T, typename Compare>
+void mergesort_natural (T A[],          // Array to be sorted
+                        uint32_t num,   // Size of the array
+                        void * buffer,  // Raw memory for num/2
+                                        // elements (or NULL)
+                        Compare less)   // Strict weak ordering
+{
+    detail::kernels<T, Compare> k = { less };
+    k.mergesort_natural_buffer (A, num, (T *) buffer);
+}
+
+template <typename T, typename Compare>
+inline void mergesort_natural (T A[], uint32_t num, Compare less)
+{
+    mergesort_natural (A, num, (void *)NULL, less);
+}
+
+// Overloads using std::less<T>, i.e. the operator '<'
+
+template <typename T>
+inline void heapsort (T A[], uint32_t num)
+{
+    heapsort (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void heapsort_floyd (T A[], uint32_t num)
+{
+    heapsort_floyd (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void heapsort_branchless (T A[], uint32_t num)
+{
+    heapsort_branchless (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void insertionsort_simple (T A[], uint32_t num)
+{
+    insertionsort_simple (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void insertionsort_chained_swaps (T A[], uint32_t num)
+{
+    insertionsort_chained_swaps (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void insertionsort_binary_search (T A[], uint32_t num)
+{
+    insertionsort_binary_search (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void insertionsort_biased_binary_search (T A[], uint32_t num)
+{
+    insertionsort_biased_binary_search (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void smoothsort (T A[], uint32_t num)
+{
+    smoothsort (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void smoothsort_fib_1 (T A[], uint32_t num)
+{
+    smoothsort_fib_1 (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void smoothsort_pow2_1 (T A[], uint32_t num)
+{
+    smoothsort_pow2_1 (A, num, std::less<T>());
+}
+
+template <typename T>
+inline void mergesort_natural (T A[], uint32_t num)
+{
+    mergesort_natural (A, num, (void *)NULL, std::less<T>());
+}
+
+} // namespace sorting
+
+#undef LESS
+#undef LESS_EQ
+#undef MOVE
+#undef MOVE_LEFT
+#undef MOVE_RIGHT
+#undef BUF_ALLOC
+#undef BUF_FREE
+#undef BUF_FILL
+#undef BUF_CLEAR
+#undef KERNEL_STATIC
+#undef KERNEL_INLINE
+#undef PAYLOAD_MOVE
+#undef PAYLOAD_SAVE
+#undef PAYLOAD_LOAD
+#undef PAYLOAD_ARRAY
+#undef PAYLOAD_INIT
+#undef PAYLOAD_PARAMS
+#undef PAYLOAD_ARGS
+#undef KERNEL
+#undef sortindex
+
+#endif // _SORTING_MKR_HPP_
@@ -0,0 +1,170 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    sortkernel.h
+
+    Operations on the elements used by the kernels of the sorting
+    functions (heapsort_kernel.h, insertionsort_kernel.h,
+    mergesort_kernel.h and smoothsort_engine.h). The kernels are
+    written once, and instantiated twice:
+
+        - By the C files, for 'sorteddatatype' and the operator
+          '<'. They get the definitions below
+
+        - By sorting.hpp, inside a class template, for an element
+          type T and a comparison object 'less'. It defines these
+          macros before including this file, and the kernels
+          become member functions (see sorting.hpp)
+
+    The macros are:
+
+        LESS(a,b)           a < b
+        LESS_EQ(a,b)        a <= b
+        MOVE(x)             The value of x, that won't be used
+                            again (std::move() in C++)
+        MOVE_LEFT(d,s,n)    Move n elements from s to d <= s
+        MOVE_RIGHT(d,s,n)   Move n elements from s to d >= s
+        BUF_ALLOC(n)        Allocate raw memory for n elements
+        BUF_FREE(p)         Free it
+        BUF_FILL(p,s,n)     Move n elements from s to the raw
+                            memory at p (constructing them)
+        BUF_CLEAR(p,n)      Destroy the n elements at p, leaving
+                            raw memory again
+        KERNEL_STATIC       Storage class of the helper functions
+                            ('static' in C, nothing in C++)
+
+    The hot helpers that must be inlined even when they grow
+    large (as interheap_sift() with the 128 bit mask of
+    smoothsort_64) are declared KERNEL_INLINE, which forces it
+    with GCC, Clang and MSVC.
+
+    The comparisons translate the operators as follows (the
+    ordering must be a strict weak ordering):
+
+        a <  b   -->   LESS(a,b)
+        a >  b   -->   LESS(b,a)
+        a <= b   -->   LESS_EQ(a,b)
+        a >= b   -->   LESS_EQ(b,a)
+
+    In C++, LESS_EQ(a,b) is !less(b,a). In C it is the operator
+    '<=' itself: !(b < a) is not the same with NaNs, and the
+    compiler generates different (and slower) code for it.
+
+    The positions and sizes in the arrays are of type 'sortindex'
+    (uint32_t). A C file may define KERNEL_64 before including
+    any kernel, to get the variants for more than 4G elements:
+
+        sortindex           size_t
+        KERNEL(x)           Name of the public function x of the
+                            kernel (x, or x_64 with KERNEL_64)
+
+    The families of heap sizes of smoothsort use larger tables
+    and masks then (see smoothsort_mask.h).
+
+    A C file may define KERNEL_PAYLOAD instead, to get the
+    variants that move a parallel array of payloads P[] along
+    with the keys A[] (P[i] stays with A[i]). Then KERNEL(x) is
+    x_payload, the public functions take P[] after A[], and the
+    kernels call these hooks (that do nothing otherwise) next to
+    every move of a key. Their arguments are pointers to keys:
+
+        PAYLOAD_MOVE(d,s)   Move the payload of *s to that of *d
+        PAYLOAD_SAVE(s)     Save the payload of *s (one at a time)
+        PAYLOAD_LOAD(d)     Give the saved payload to *d
+        PAYLOAD_ARRAY       'payloadtype P[],' in the public
+                            functions
+        PAYLOAD_INIT        Declaration of 'pay' (the arrays and
+                            the saved payload) in them
+        PAYLOAD_PARAMS      ', payloadref * pay' in the helpers
+        PAYLOAD_ARGS        ', pay' in the calls to them
+
+    The comparisons don't see the payloads, so they only read
+    the keys, which are packed together
+    -------------------------------------------------------------
+*/
+
+#ifndef _SORTKERNEL_MKR_H_
+#define _SORTKERNEL_MKR_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef LESS
+
+#define LESS(a,b)          ((a) < (b))
+#define LESS_EQ(a,b)       ((a) <= (b))
+#define MOVE(x)            (x)
+#define MOVE_LEFT(d,s,n)   memmove (d, s, (n) * sizeof(sorteddatatype))
+#define MOVE_RIGHT(d,s,n)  memmove (d, s, (n) * sizeof(sorteddatatype))
+#define BUF_ALLOC(n)       malloc ((n) * sizeof(sorteddatatype))
+#define BUF_FREE(p)        free (p)
+#define BUF_FILL(p,s,n)    memcpy (p, s, (n) * sizeof(sorteddatatype))
+#define BUF_CLEAR(p,n)     ((void)(p), (void)(n))
+#define KERNEL_STATIC      static
+
+#endif // LESS
+
+#ifndef KERNEL_INLINE
+#if defined(__GNUC__)
+#define KERNEL_INLINE      inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define KERNEL_INLINE      __forceinline
+#else
+#define KERNEL_INLINE      inline
+#endif
+#endif // KERNEL_INLINE
+
+#ifndef sortindex
+#ifdef KERNEL_64
+#define sortindex          size_t
+#else
+#define sortindex          uint32_t
+#endif
+#endif // sortindex
+
+#ifndef KERNEL
+#if defined(KERNEL_64)
+#define KERNEL(x)          x##_64
+#elif defined(KERNEL_PAYLOAD)
+#define KERNEL(x)          x##_payload
+#else
+#define KERNEL(x)          x
+#endif
+#endif // KERNEL
+
+#ifdef KERNEL_PAYLOAD
+
+typedef struct
+{
+    sorteddatatype * keys;      // A[] and P[] of the public function
+    payloadtype * payloads;
+    payloadtype saved;          // See PAYLOAD_SAVE()
+}
+payloadref;
+
+#define PAYLOAD_OF(x)      (pay->payloads + ((x) - pay->keys))
+#define PAYLOAD_MOVE(d,s)  (*PAYLOAD_OF(d) = *PAYLOAD_OF(s))
+#define PAYLOAD_SAVE(s)    (pay->saved = *PAYLOAD_OF(s))
+#define PAYLOAD_LOAD(d)    (*PAYLOAD_OF(d) = pay->saved)
+#define PAYLOAD_ARRAY      payloadtype P[],
+#define PAYLOAD_INIT       payloadref pay_ = { A, P, 0 }, \
+                                      * pay = &pay_;
+#define PAYLOAD_PARAMS     , payloadref * pay
+#define PAYLOAD_ARGS       , pay
+
+#else
+
+#define PAYLOAD_MOVE(d,s)  ((void)0)
+#define PAYLOAD_SAVE(s)    ((void)0)
+#define PAYLOAD_LOAD(d)    ((void)0)
+#define PAYLOAD_ARRAY
+#define PAYLOAD_INIT
+#define PAYLOAD_PARAMS
+#define PAYLOAD_ARGS
+
+#endif // KERNEL_PAYLOAD
+
+#endif // _SORTKERNEL_MKR_H_
@@ -0,0 +1,295 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    sortnet.c
+
+    Sorting networks for small arrays (up to SORTNET_MAX elements).
+    A sorting network is a fixed sequence of comparators, each of
+    which puts two elements in order. The sequence doesn't depend
+    on the data, so there are no branches to mispredict, and many
+    comparators can run at the same time as a min. and a max. of
+    SIMD vectors. There are two functions in this file:
+
+       1) sortnet() sorts an array with a bitonic sorter
+          (see sortnet_kernel.h)
+
+       2) sortnet_merge() merges two sorted halves of an array
+          with a bitonic merger: the second half is copied in
+          reverse order after the first one, and the result (a
+          "bitonic" sequence) is sorted by the second half of the
+          network alone
+
+    The array is copied to an aligned buffer of 2^k elements,
+    padded with +infinity, where the network sorts it. There are
+    versions of the network for SSE2 (2 doubles per vector), AVX2
+    (4) and AVX-512 (8). The best one supported by the processor
+    is chosen once, when the program starts. With other compilers
+    or processors, a scalar version of the same network is used.
+
+    A NaN can't be compared with the padding, so the network could
+    leave it beyond the first num elements, and copy back an
+    infinity in its place. The NaNs are moved to the end of the
+    array before, and the network only sorts the rest.
+
+    The vector versions assume that sorteddatatype is double.
+    The sort is not stable (but two equal doubles are only
+    distinguishable when they are 0.0 and -0.0). Arrays of more
+    than SORTNET_MAX elements are sorted with quicksort()
+    ---------------------------------------------------------------
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "sorting.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SORTNET_X86
+#include <immintrin.h>
+#endif
+
+#ifdef __GNUC__
+#define ALIGNED(n)  __attribute__ ((aligned (n)))
+#else
+#define ALIGNED(n)
+#endif
+
+typedef void (*netfunc) (sorteddatatype B[], uint32_t p);
+
+// Scalar version
+
+#define NAME(x)     x##_scalar
+#define TARGET
+#define W           1
+#define vec         sorteddatatype
+#define LOAD(p)     (*(p))
+#define STORE(p,v)  (*(p) = (v))
+#define MIN(a,b)    ((a) < (b) ? (a) : (b))
+#define MAX(a,b)    ((a) > (b) ? (a) : (b))
+#define REV(v)      (v)
+#include "sortnet_kernel.h"
+
+#ifdef SORTNET_X86
+
+// SSE2 version (2 doubles per vector)
+
+__attribute__ ((target ("sse2")))
+static inline __m128d invec_sse2 (__m128d v, uint32_t m)
+{
+    __m128d p;                              // m is always 1
+
+    (void) m;
+    p = _mm_shuffle_pd (v, v, 1);
+    return _mm_move_sd (_mm_max_pd (v, p), _mm_min_pd (v, p));
+}
+
+#define NAME(x)     x##_sse2
+#define TARGET      __attribute__ ((target ("sse2")))
+#define W           2
+#define vec         __m128d
+#define LOAD(p)     _mm_loadu_pd (p)
+#define STORE(p,v)  _mm_storeu_pd ((p), (v))
+#define MIN(a,b)    _mm_min_pd ((a), (b))
+#define MAX(a,b)    _mm_max_pd ((a), (b))
+#define REV(v)      _mm_shuffle_pd ((v), (v), 1)
+#include "sortnet_kernel.h"
+
+// AVX2 version (4 doubles per vector)
+
+__attribute__ ((target ("avx2")))
+static inline __m256d invec_avx2 (__m256d v, uint32_t m)
+{
+    __m256d p;
+
+    switch (m)
+    {
+    case 1:                                 // Lanes: 1 0 3 2
+        p = _mm256_permute_pd (v, 0x5);
+        return _mm256_blend_pd (_mm256_min_pd (v, p),
+                                _mm256_max_pd (v, p), 0xA);
+    case 2:                                 // Lanes: 2 3 0 1
+        p = _mm256_permute4x64_pd (v, 0x4E);
+        return _mm256_blend_pd (_mm256_min_pd (v, p),
+                                _mm256_max_pd (v, p), 0xC);
+    default:                                // Lanes: 3 2 1 0
+        p = _mm256_permute4x64_pd (v, 0x1B);
+        return _mm256_blend_pd (_mm256_min_pd (v, p),
+                                _mm256_max_pd (v, p), 0xC);
+    }
+}
+
+#define NAME(x)     x##_avx2
+#define TARGET      __attribute__ ((target ("avx2")))
+#define W           4
+#define vec         __m256d
+#define LOAD(p)     _mm256_loadu_pd (p)
+#define STORE(p,v)  _mm256_storeu_pd ((p), (v))
+#define MIN(a,b)    _mm256_min_pd ((a), (b))
+#define MAX(a,b)    _mm256_max_pd ((a), (b))
+#define REV(v)      _mm256_permute4x64_pd ((v), 0x1B)
+#include "sortnet_kernel.h"
+
+// AVX-512 version (8 doubles per vector)
+
+__attribute__ ((target ("avx512f")))
+static inline __m512d invec_avx512 (__m512d v, uint32_t m)
+{
+    __m512i lane;
+    __m512d p;
+    __mmask8 upper;       // Lanes that get the max.
+
+    lane = _mm512_set_epi64 (7, 6, 5, 4, 3, 2, 1, 0);
+    p = _mm512_permutexvar_pd (
+            _mm512_xor_si512 (lane, _mm512_set1_epi64 (m)), v);
+    upper = _mm512_test_epi64_mask (
+            lane, _mm512_set1_epi64 (m & 4 ? 4 : m & 2 ? 2 : 1));
+
+    return _mm512_mask_blend_pd (upper, _mm512_min_pd (v, p),
+                                        _mm512_max_pd (v, p));
+}
+
+#define NAME(x)     x##_avx512
+#define TARGET      __attribute__ ((target ("avx512f")))
+#define W           8
+#define vec         __m512d
+#define LOAD(p)     _mm512_loadu_pd (p)
+#define STORE(p,v)  _mm512_storeu_pd ((p), (v))
+#define MIN(a,b)    _mm512_min_pd ((a), (b))
+#define MAX(a,b)    _mm512_max_pd ((a), (b))
+#define REV(v)      _mm512_permutexvar_pd (                        \
+                        _mm512_set_epi64 (0, 1, 2, 3, 4, 5, 6, 7), \
+                        (v))
+#include "sortnet_kernel.h"
+
+#endif // SORTNET_X86
+
+static netfunc net_sort = sort_scalar;     // Best versions for
+static netfunc net_merge = merge_scalar;   // this processor, and
+static uint32_t net_width = 1;             // their vector width
+
+#ifdef SORTNET_X86
+
+__attribute__ ((constructor))
+static void choose_network (void)   // Run once, when the program
+{                                   // (or library) is loaded
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx512f"))
+    {
+        net_sort = sort_avx512;
+        net_merge = merge_avx512;
+        net_width = 8;
+    }
+    else if (__builtin_cpu_supports ("avx2"))
+    {
+        net_sort = sort_avx2;
+        net_merge = merge_avx2;
+        net_width = 4;
+    }
+    else if (__builtin_cpu_supports ("sse2"))
+    {
+        net_sort = sort_sse2;
+        net_merge = merge_sse2;
+        net_width = 2;
+    }
+}
+
+#endif // SORTNET_X86
+
+static inline uint32_t padded_size (uint32_t num, uint32_t w)
+{
+    uint32_t p;                     // Least power of 2 that is
+                                    // >= num and >= w
+    for (p=w; p<num; p<<=1)
+        ;
+
+    return p;
+}
+
+static inline uint32_t nans_last (sorteddatatype A[], uint32_t num)
+{
+    sorteddatatype tmp;             // Move the NaNs to the end,
+    uint32_t i, k;                  // keeping the order of the
+                                    // rest, and return how many
+    for (k=0; k<num; k++)           // elements are not NaN
+        if (A[k] != A[k])
+            break;                  // Usually, there are none
+
+    for (i=k+1; i<num; i++)
+    {
+        tmp = A[i];                 // A[0...k-1] are not NaN and
+        A[i] = A[k];                // A[k...i-1] are NaN. Swap
+        A[k] = tmp;                 // always, but only advance
+        k += tmp == tmp;            // k when tmp is not NaN
+    }
+
+    return k;
+}
+
+void sortnet (sorteddatatype A[],          // Array to be sorted
+              uint32_t num)                // Size of the array
+{
+    sorteddatatype B[SORTNET_MAX] ALIGNED (64);
+    uint32_t p, i;
+
+    if (num < 2)
+        return;
+
+    if (num > SORTNET_MAX)
+    {
+        quicksort (A, num);
+        return;
+    }
+                                    // The NaNs would be lost among
+    num = nans_last (A, num);       // the padding, so they stay
+                                    // out of the network
+    if (num < 2)
+        return;
+
+    p = padded_size (num, net_width);
+
+    memcpy (B, A, num * sizeof(sorteddatatype));
+    for (i=num; i<p; i++)
+        B[i] = HUGE_VAL;
+
+    net_sort (B, p);
+
+    memcpy (A, B, num * sizeof(sorteddatatype));
+}
+
+void sortnet_merge (sorteddatatype A[],    // Array to be merged
+                    uint32_t num,          // Size of the array
+                    uint32_t mid)          // Start of 2nd half
+{
+    sorteddatatype B[SORTNET_MAX] ALIGNED (64);
+    uint32_t p, i, j, k1, k2;
+
+    if (mid == 0 || mid >= num)
+        return;
+
+    if (num > SORTNET_MAX)
+    {
+        quicksort (A, num);
+        return;
+    }
+
+    k1 = nans_last (A, mid);              // Elements of each half
+    k2 = nans_last (A+mid, num-mid);      // that are not NaN
+
+    p = padded_size (k1+k2, net_width);
+                                          // First half ascending,
+    memcpy (B, A, k1 * sizeof(sorteddatatype));   // then padding
+    for (i=k1; i<p-k2; i++)               // and the second half
+        B[i] = HUGE_VAL;                  // descending
+    for (j=mid+k2; j>mid; j--)
+        B[i++] = A[j-1];
+                                          // The NaNs of the first
+    memmove (A+k1+k2, A+k1,               // half go just before
+             (mid-k1) * sizeof(sorteddatatype));  // the ones of the
+                                          // second half, at the end
+    net_merge (B, p);
+
+    memcpy (A, B, (k1+k2) * sizeof(sorteddatatype));
+}
@@ -0,0 +1,109 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    sortnet_kernel.h
+
+    Bitonic sorting network for a power of 2 number of elements,
+    written for vectors of W elements. This is not a regular
+    header: sortnet.c includes it once per instruction set, with
+    these macros defined:
+
+        NAME(x)      Name of the function x for this set
+        TARGET       Attribute that enables the set (or nothing)
+        W            Elements per vector (a power of 2)
+        vec          Vector type
+        LOAD(p)      Load W elements from address p
+        STORE(p,v)   Store the W elements of v at address p
+        MIN(a,b)     Lane by lane, a<b ? a : b
+        MAX(a,b)     Lane by lane, a>b ? a : b
+        REV(v)       The lanes of v in reverse order
+
+    and, if W>1, a function NAME(invec)(v,m) that compares every
+    lane with lane^m, leaving the min. in the lower one and the
+    max. in the upper one. That's how the comparators of distance
+    less than W work, inside every vector.
+
+    Note that MIN() and MAX() return their second argument when
+    both are equal. The comparators pass the arguments in
+    opposite orders to each one, so that they never duplicate a
+    value (as it would happen with 0.0 and -0.0).
+
+    The network is the bitonic sorter with "flips": at every
+    stage, the first comparator of every block of s elements
+    pairs the element t with the element s-1-t, and the rest
+    are half-cleaners (pairing t with t+d). All of them put the
+    min. first, so every block is sorted in ascending order
+    -------------------------------------------------------------
+*/
+
+TARGET static void NAME(cleaners) (
+        sorteddatatype B[],     // Array of p elements (2^k >= W)
+        uint32_t       p,
+        uint32_t       d)       // Distance of the first comparator
+{
+    uint32_t i, t;
+    vec a, c;
+
+    for (; d>=W; d>>=1)                 // Comparators between
+        for (i=0; i<p; i+=2*d)          // whole vectors
+            for (t=i; t<i+d; t+=W)
+            {
+                a = LOAD (B+t);
+                c = LOAD (B+t+d);
+                STORE (B+t,   MIN (a, c));
+                STORE (B+t+d, MAX (c, a));
+            }
+#if W > 1
+    for (; d; d>>=1)                    // Comparators inside
+        for (i=0; i<p; i+=W)            // every vector
+            STORE (B+i, NAME(invec) (LOAD (B+i), d));
+#endif
+}
+
+TARGET static void NAME(sort) (
+        sorteddatatype B[],     // Array of p elements (2^k >= W)
+        uint32_t       p)
+{
+    uint32_t s, i, t, u;
+    vec a, c;
+
+    for (s=2; s<=p; s<<=1)              // Blocks of s elements
+    {
+#if W > 1
+        if (s <= W)                     // Flip inside the vectors
+            for (i=0; i<p; i+=W)
+                STORE (B+i, NAME(invec) (LOAD (B+i), s-1));
+        else
+#endif
+            for (i=0; i<p; i+=s)        // Flip between vectors:
+                for (t=0; t<s/2; t+=W)  // the second one reversed
+                {
+                    u = i + s - W - t;
+                    a = LOAD (B+i+t);
+                    c = REV (LOAD (B+u));
+                    STORE (B+i+t, MIN (a, c));
+                    STORE (B+u,   REV (MAX (c, a)));
+                }
+
+        NAME(cleaners) (B, p, s>>2);
+    }
+}
+
+TARGET static void NAME(merge) (
+        sorteddatatype B[],     // Bitonic array of p elements
+        uint32_t       p)       // (2^k >= W)
+{
+    NAME(cleaners) (B, p, p>>1);
+}
+
+#undef NAME
+#undef TARGET
+#undef W
+#undef vec
+#undef LOAD
+#undef STORE
+#undef MIN
+#undef MAX
+#undef REV
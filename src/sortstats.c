@@ -0,0 +1,27 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    sortstats.c
+
+    Per-thread counters of the optional instrumentation (see
+    sortstats.h)
+    -------------------------------------------------------------
+*/
+
+#include <string.h>
+
+#include "sortstats.h"
+
+SORTSTATS_THREAD sortstats sortstats_counters;
+
+sortstats * sortstats_get (void)
+{
+    return &sortstats_counters;
+}
+
+void sortstats_reset (void)
+{
+    memset (&sortstats_counters, 0, sizeof(sortstats_counters));
+}
@@ -0,0 +1,103 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    sortstats.h
+
+    Optional instrumentation of the sorting functions. When the
+    library is compiled with SORTING_STATS defined, the sift
+    functions count the comparisons between elements, the reads
+    and writes of elements in the array and the number of levels
+    traversed by every sift. The counters are per-thread, so
+    several threads can sort (and measure) at the same time.
+
+    Without SORTING_STATS the macros below expand to nothing,
+    and the sorting functions are exactly as fast as before.
+    sortstats_get() and sortstats_reset() are available anyway;
+    in that case the counters just stay at zero.
+
+    Typical use:
+
+        sortstats_reset ();
+        heapsort_floyd (A, num);
+        printf ("%llu\n", sortstats_get()->comparisons);
+    -------------------------------------------------------------
+*/
+
+#ifndef _SORTSTATS_MKR_H_
+#define _SORTSTATS_MKR_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint64_t comparisons;    // Comparisons between elements
+    uint64_t reads;          // Elements read from the array
+    uint64_t writes;         // Elements written to the array
+    uint64_t sifts;          // Calls to the sift functions
+    uint64_t sift_levels;    // Levels traversed by all the sifts
+    uint32_t sift_depth_max; // Max. levels traversed in one sift
+    uint32_t sift_depth;     // Levels of the current sift (internal)
+}
+sortstats;
+
+#if defined(_MSC_VER)
+#define SORTSTATS_THREAD __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+      !defined(__STDC_NO_THREADS__)
+#define SORTSTATS_THREAD _Thread_local
+#else
+#define SORTSTATS_THREAD __thread
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern SORTSTATS_THREAD sortstats sortstats_counters;
+
+sortstats * sortstats_get (void);    // Counters of this thread
+
+void sortstats_reset (void);         // Set them to zero
+
+#ifdef __cplusplus
+}
+#endif
+
+// Macros used by the sorting functions. They are expressions,
+// so that they can be used with the comma operator inside of
+// conditions (e.g. "if (p == 0 || (STAT_CMP(1), H[p] >= tmp))")
+
+#ifdef SORTING_STATS
+
+#define STAT_CMP(n)    (sortstats_counters.comparisons += (n))
+#define STAT_READ(n)   (sortstats_counters.reads += (n))
+#define STAT_WRITE(n)  (sortstats_counters.writes += (n))
+#define STAT_LEVEL()   (sortstats_counters.sift_depth ++)
+#define STAT_SIFT()    sortstats_end_sift ()
+
+static inline void sortstats_end_sift (void)
+{
+    sortstats * s = &sortstats_counters;
+
+    s->sifts ++;
+    s->sift_levels += s->sift_depth;
+
+    if (s->sift_depth_max < s->sift_depth)
+        s->sift_depth_max = s->sift_depth;
+
+    s->sift_depth = 0;
+}
+
+#else
+
+#define STAT_CMP(n)    ((void)0)
+#define STAT_READ(n)   ((void)0)
+#define STAT_WRITE(n)  ((void)0)
+#define STAT_LEVEL()   ((void)0)
+#define STAT_SIFT()    ((void)0)
+
+#endif
+
+#endif // _SORTSTATS_MKR_H_
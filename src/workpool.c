@@ -0,0 +1,348 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    workpool.c
+
+    Implementation of the work-stealing thread pool (see
+    workpool.h). Every queue (one per worker, plus the shared
+    one for the tasks submitted from outside) is a circular
+    buffer protected by its own mutex. The tasks of the sorting
+    functions are coarse (thousands of elements each), so a lock
+    per queue costs nothing noticeable and is much simpler than
+    a lock-free deque.
+
+    The pool mutex protects only the counters used to put idle
+    workers to sleep and to wait for the completion of the
+    tasks. Lock order: pool first, then queue
+    -------------------------------------------------------------
+*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L     // For sysconf()
+#endif
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "workpool.h"
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+    !defined(__STDC_NO_THREADS__)
+#define WORKPOOL_THREAD _Thread_local
+#else
+#define WORKPOOL_THREAD __thread
+#endif
+
+typedef struct
+{
+    workfunc func;
+    void *   arg;
+}
+worktask;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    worktask * tasks;     // Circular buffer of tasks
+    size_t     cap;       // Capacity of the buffer
+    size_t     head;      // Position of the oldest task
+    size_t     count;     // Number of tasks in the buffer
+}
+workqueue;
+
+struct workpool
+{
+    int         nthreads;
+    pthread_t * threads;
+    workqueue * queues;   // One per thread
+    workqueue   inject;   // Tasks submitted from outside (FIFO)
+
+    pthread_mutex_t lock;
+    pthread_cond_t  wakeup;   // Signaled when a task is queued
+    pthread_cond_t  done;     // Signaled when 'pending' gets 0
+    long      queued;         // Tasks waiting in the queues
+    long      pending;        // Tasks queued or running
+    int       started;        // Workers that took their index
+    int       stop;           // Set by workpool_destroy()
+};
+
+static WORKPOOL_THREAD workpool * current_pool;  // Of this worker
+static WORKPOOL_THREAD int current_index;        // (if it is one)
+
+static int queue_push (workqueue * q, worktask t)
+{
+    worktask * tasks;
+    size_t i;
+
+    pthread_mutex_lock (&q->lock);
+
+    if (q->count == q->cap)                  // Grow the buffer,
+    {                                        // unrolling the
+        tasks = malloc (2*q->cap * sizeof(worktask)); // circle
+        if (!tasks)
+        {
+            pthread_mutex_unlock (&q->lock);
+            return 0;
+        }
+        for (i=0; i<q->count; i++)
+            tasks[i] = q->tasks[(q->head+i) % q->cap];
+        free (q->tasks);
+        q->tasks = tasks;
+        q->head = 0;
+        q->cap *= 2;
+    }
+
+    q->tasks[(q->head + q->count) % q->cap] = t;
+    q->count ++;
+
+    pthread_mutex_unlock (&q->lock);
+    return 1;
+}
+
+static int queue_take (workqueue * q, worktask * t, int newest)
+{
+    int found = 0;
+
+    pthread_mutex_lock (&q->lock);
+
+    if (q->count)
+    {
+        q->count --;
+        if (newest)                         // Owner: back (LIFO)
+            *t = q->tasks[(q->head + q->count) % q->cap];
+        else                                // Thief: front (FIFO)
+        {
+            *t = q->tasks[q->head];
+            q->head = (q->head + 1) % q->cap;
+        }
+        found = 1;
+    }
+
+    pthread_mutex_unlock (&q->lock);
+    return found;
+}
+
+static int find_task (workpool * pool, int me, worktask * t)
+{
+    int k;
+                                           // Own queue first (the
+    if (queue_take (pool->queues+me, t, 1))  // tasks submitted by
+        return 1;                          // this worker), then the
+                                           // external tasks in order
+    if (queue_take (&pool->inject, t, 0))  // of submission, then try
+        return 1;                          // to steal from the others
+
+    for (k=1; k<pool->nthreads; k++)
+        if (queue_take (pool->queues + (me+k) % pool->nthreads,
+                        t, 0))
+            return 1;
+
+    return 0;
+}
+
+static void * worker (void * arg)
+{
+    workpool * pool;
+    worktask t;
+    int me;
+
+    pool = (workpool *) arg;
+
+    pthread_mutex_lock (&pool->lock);     // The index is taken
+    me = pool->started++;                 // in order of arrival
+    pthread_mutex_unlock (&pool->lock);
+
+    current_pool = pool;
+    current_index = me;
+
+    for (;;)
+    {
+        if (!find_task (pool, me, &t))
+        {
+            pthread_mutex_lock (&pool->lock);     // Nothing to do.
+                                                  // Sleep until
+            while (pool->queued <= 0 && !pool->stop)   // there is
+                pthread_cond_wait (&pool->wakeup, &pool->lock);
+
+            if (pool->stop)
+            {
+                pthread_mutex_unlock (&pool->lock);
+                return NULL;
+            }
+
+            pthread_mutex_unlock (&pool->lock);
+            continue;
+        }
+
+        pthread_mutex_lock (&pool->lock);
+        pool->queued --;
+        pthread_mutex_unlock (&pool->lock);
+
+        t.func (t.arg);
+
+        pthread_mutex_lock (&pool->lock);
+        if (--pool->pending == 0)
+            pthread_cond_broadcast (&pool->done);
+        pthread_mutex_unlock (&pool->lock);
+    }
+}
+
+static void release (workpool * pool, int nqueues);
+
+int workpool_processors (void)
+{
+    long n;
+
+    n = sysconf (_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? (int)n : 1;
+}
+
+workpool * workpool_create (int nthreads)
+{
+    workpool * pool;
+    int i, started;
+
+    if (nthreads < 1)
+        nthreads = workpool_processors ();
+
+    pool = calloc (1, sizeof(workpool));
+    if (!pool)
+        return NULL;
+
+    pool->nthreads = nthreads;
+    pool->threads = calloc (nthreads, sizeof(pthread_t));
+    pool->queues = calloc (nthreads, sizeof(workqueue));
+
+    if (!pool->threads || !pool->queues)
+    {
+        free (pool->threads);
+        free (pool->queues);
+        free (pool);
+        return NULL;
+    }
+
+    pthread_mutex_init (&pool->lock, NULL);
+    pthread_cond_init (&pool->wakeup, NULL);
+    pthread_cond_init (&pool->done, NULL);
+
+    for (i=0; i<nthreads; i++)
+    {
+        pthread_mutex_init (&pool->queues[i].lock, NULL);
+        pool->queues[i].cap = 64;
+        pool->queues[i].tasks = malloc (64 * sizeof(worktask));
+    }
+
+    pthread_mutex_init (&pool->inject.lock, NULL);
+    pool->inject.cap = 64;
+    pool->inject.tasks = malloc (64 * sizeof(worktask));
+
+    for (i=0; i<nthreads && pool->queues[i].tasks; i++)
+        ;                                // (Check the buffers)
+    started = 0;
+    if (i == nthreads && pool->inject.tasks)
+        while (started < nthreads &&
+               !pthread_create (pool->threads+started, NULL,
+                                worker, pool))
+            started ++;
+
+    if (started < nthreads)              // On failure, stop the
+    {                                    // threads that were
+        pthread_mutex_lock (&pool->lock);    // already started
+        pool->stop = 1;                      // and give up
+        pthread_cond_broadcast (&pool->wakeup);
+        pthread_mutex_unlock (&pool->lock);
+
+        while (started > 0)
+            pthread_join (pool->threads[--started], NULL);
+
+        release (pool, nthreads);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void workpool_submit (workpool * pool, workfunc func, void * arg)
+{
+    worktask t;
+    workqueue * q;
+
+    t.func = func;
+    t.arg = arg;
+
+    pthread_mutex_lock (&pool->lock);
+
+    if (current_pool == pool)      // From a worker: its own queue
+        q = pool->queues + current_index;
+    else                           // From outside: the shared one
+        q = &pool->inject;
+
+    if (!queue_push (q, t))
+    {
+        pthread_mutex_unlock (&pool->lock);   // Out of memory:
+        func (arg);                           // run it here
+        return;
+    }
+
+    pool->pending ++;
+    pool->queued ++;
+    pthread_cond_signal (&pool->wakeup);
+
+    pthread_mutex_unlock (&pool->lock);
+}
+
+void workpool_wait (workpool * pool)
+{
+    pthread_mutex_lock (&pool->lock);
+
+    while (pool->pending > 0)
+        pthread_cond_wait (&pool->done, &pool->lock);
+
+    pthread_mutex_unlock (&pool->lock);
+}
+
+int workpool_threads (const workpool * pool)
+{
+    return pool->nthreads;
+}
+
+void workpool_destroy (workpool * pool)
+{
+    int i;
+
+    pthread_mutex_lock (&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast (&pool->wakeup);
+    pthread_mutex_unlock (&pool->lock);
+
+    for (i=0; i<pool->nthreads; i++)
+        pthread_join (pool->threads[i], NULL);
+
+    release (pool, pool->nthreads);
+}
+
+static void release (workpool * pool, int nqueues)
+{
+    int i;
+
+    for (i=0; i<nqueues; i++)
+    {
+        pthread_mutex_destroy (&pool->queues[i].lock);
+        free (pool->queues[i].tasks);
+    }
+
+    pthread_mutex_destroy (&pool->inject.lock);
+    free (pool->inject.tasks);
+
+    pthread_cond_destroy (&pool->done);
+    pthread_cond_destroy (&pool->wakeup);
+    pthread_mutex_destroy (&pool->lock);
+
+    free (pool->queues);
+    free (pool->threads);
+    free (pool);
+}
@@ -0,0 +1,53 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    -------------------------------------------------------------
+    workpool.h
+
+    Small work-stealing thread pool used by the parallel sorting
+    functions. Every worker thread has its own queue of tasks. A
+    worker takes tasks from the back of its own queue (the most
+    recent first), and when it runs out of them it steals tasks
+    from the front of the other queues (the oldest first). This
+    keeps all threads busy when the tasks have very different
+    sizes, like the buckets of a sample sort of skewed data.
+
+    Tasks submitted from a worker thread (i.e. from inside
+    another task) go to the queue of that worker. Tasks
+    submitted from any other thread go to a shared queue, and
+    they are started in the order of submission (before stealing
+    from other workers). So a caller that submits the largest
+    tasks first gets them started first.
+
+    The implementation uses POSIX threads
+    -------------------------------------------------------------
+*/
+
+#ifndef _WORKPOOL_MKR_H_
+#define _WORKPOOL_MKR_H_
+
+typedef void (*workfunc) (void * arg);
+
+typedef struct workpool workpool;
+
+workpool * workpool_create (int nthreads);  // NULL on failure.
+                                            // If nthreads<1, use
+                                            // one per processor
+void workpool_submit (workpool * pool,
+                      workfunc   func,      // Run func(arg) in
+                      void *     arg);      // some worker thread
+
+void workpool_wait (workpool * pool);       // Wait until all the
+                                            // submitted tasks are
+                                            // finished (and also
+                                            // the tasks submitted
+                                            // by them)
+
+void workpool_destroy (workpool * pool);    // Stop the threads
+
+int workpool_threads (const workpool * pool);   // Num. of threads
+
+int workpool_processors (void);             // Num. of processors
+
+#endif // _WORKPOOL_MKR_H_
@@ -0,0 +1,200 @@
+/*
+    Copyright (c) 2013, Martin Knoblauch Revuelta
+    See accompanying LICENSE
+
+    ---------------------------------------------------------------
+    nantest.c
+
+    Test of the sorting functions with NaNs in the input. There is
+    no order with NaNs for the operator '<', so most functions
+    only promise not to lose any element: the output must be a
+    permutation of the input (bit by bit, so that a NaN replaced
+    by an infinity, or a -0.0 by a 0.0, is detected). Besides:
+
+        sortnet()        Up to SORTNET_MAX elements, leaves the
+                         rest sorted and the NaNs at the end (also
+                         sortnet_merge())
+
+        radixsort()      At any size, leaves the total order of
+                         radixsort.c: -NaN < -inf < ... < -0.0 <
+                         +0.0 < ... < +inf < +NaN
+
+    The arrays are random, with 0, a few, half or all of their
+    elements being NaN, and every size from 1 to 3*SORTNET_MAX
+    (plus a few larger ones, so that quicksort() calls sortnet()
+    for its small partitions, and radixsort() makes its passes).
+
+    Build and run it with "make check" (see the Makefile at the
+    top of the repository), or from the src directory with
+    something like:
+
+        cc -O2 -I. -o ../test/nantest ../test/nantest.c *.c \
+           -lm -lpthread
+
+    It prints the failures and returns EXIT_FAILURE if any
+    ---------------------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sorting.h"
+
+static uint64_t rng_state = 88172645463325252ULL;
+
+static uint64_t rng (void)     // xorshift64*
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+static int cmp_bits (const void * a, const void * b)
+{
+    uint64_t x, y;
+
+    memcpy (&x, a, sizeof(x));
+    memcpy (&y, b, sizeof(y));
+    return x < y ? -1 : x > y;
+}
+
+static int same_elements (const sorteddatatype A[],
+                          const sorteddatatype B[], uint32_t num)
+{
+    static sorteddatatype X[2000], Y[2000];
+
+    memcpy (X, A, num * sizeof(sorteddatatype));   // Compare the
+    memcpy (Y, B, num * sizeof(sorteddatatype));   // bit patterns
+    qsort (X, num, sizeof(sorteddatatype), cmp_bits);  // sorted
+    qsort (Y, num, sizeof(sorteddatatype), cmp_bits);
+    return !memcmp (X, Y, num * sizeof(sorteddatatype));
+}
+
+static int nans_last_sorted (const sorteddatatype A[], uint32_t num)
+{
+    uint32_t i;
+
+    for (i=0; i<num && !isnan (A[i]); i++)
+        if (i && A[i] < A[i-1])
+            return 0;
+
+    for (; i<num; i++)
+        if (!isnan (A[i]))
+            return 0;
+
+    return 1;
+}
+
+static uint64_t total_key (const sorteddatatype * p)
+{
+    uint64_t u;              // Same order as the keys of radixsort.c
+
+    memcpy (&u, p, sizeof(u));
+    return u ^ ((0 - (u >> 63)) | 0x8000000000000000ULL);
+}
+
+static int total_order (const sorteddatatype A[], uint32_t num)
+{
+    uint32_t i;
+
+    for (i=1; i<num; i++)
+        if (total_key (A+i) < total_key (A+i-1))
+            return 0;
+
+    return 1;
+}
+
+static void generate (sorteddatatype A[], uint32_t num, int nans)
+{
+    uint32_t i;
+
+    for (i=0; i<num; i++)
+    {
+        A[i] = (sorteddatatype)(rng() % 16) - 8;    // Duplicates,
+        if (A[i] == 0 && rng() & 1)                 // and both
+            A[i] = -0.0;                            // zeros
+        if (A[i] == 7)
+            A[i] = HUGE_VAL;
+
+        switch (nans)              // None, a few, half or all
+        {
+        case 1:  if (rng() % 8 == 0) A[i] = NAN;    break;
+        case 2:  if (rng() & 1)      A[i] = -NAN;   break;
+        case 3:  A[i] = rng() & 1 ? NAN : -NAN;     break;
+        }
+    }
+}
+
+static void run_sortnet_merge (sorteddatatype A[], uint32_t num)
+{
+    uint32_t mid = num / 3;
+
+    sortnet (A, mid);                  // Two halves, each one with
+    sortnet (A+mid, num-mid);          // its NaNs at the end
+    sortnet_merge (A, num, mid);
+}
+
+static const struct
+{
+    const char * name;
+    sortfunction func;
+    int nans_last;          // Sorted with the NaNs at the end
+                            // (up to SORTNET_MAX elements)
+    int total;              // In total order (any size)
+}
+algos[] =
+{
+    { "sortnet",             sortnet,             1, 0 },
+    { "sortnet_merge",       run_sortnet_merge,   1, 0 },
+    { "quicksort",           quicksort,           0, 0 },
+    { "quicksort_median_of_medians",
+                             quicksort_median_of_medians, 0, 0 },
+    { "sort_auto",           sort_auto,           0, 0 },
+    { "radixsort",           radixsort,           0, 1 }
+};
+
+#define NUM_ALGOS  (sizeof(algos)/sizeof(algos[0]))
+
+int main (void)
+{
+    static const uint32_t large[] = { 200, 500, 1000, 2000 };
+    sorteddatatype input[2000], work[2000];
+    uint32_t num, s;
+    unsigned a;
+    int nans, rep, failures = 0;
+
+    for (s=1; s<=3*SORTNET_MAX+4; s++)
+    for (nans=0; nans<4; nans++)
+    for (rep=0; rep<10; rep++)
+    {
+        num = s <= 3*SORTNET_MAX ? s : large[s-3*SORTNET_MAX-1];
+        generate (input, num, nans);
+
+        for (a=0; a<NUM_ALGOS; a++)
+        {
+            memcpy (work, input, num * sizeof(sorteddatatype));
+            algos[a].func (work, num);
+
+            if (!same_elements (input, work, num))
+            {
+                printf ("%s: elements lost, size %lu\n",
+                        algos[a].name, (unsigned long)num);
+                failures ++;
+            }
+            else if ((algos[a].nans_last && num <= SORTNET_MAX &&
+                      !nans_last_sorted (work, num)) ||
+                     (algos[a].total && !total_order (work, num)))
+            {
+                printf ("%s: not sorted, size %lu\n",
+                        algos[a].name, (unsigned long)num);
+                failures ++;
+            }
+        }
+    }
+
+    printf ("%d failures\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}